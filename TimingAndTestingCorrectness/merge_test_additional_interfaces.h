@@ -0,0 +1,1864 @@
+/*
+ * merge_test_additional_interfaces.h
+ *
+ *  This header file defines TestCorrectnessOfAdditionalInterfaces(), which
+ *   tests the interfaces that are built on top of MergeWithOutBuffer1() and
+ *   MergeWithOutBuffer2() (see "Additional interfaces" in README.md) on
+ *   random inputs by comparing their results with those of the corresponding
+ *   std:: algorithms. main() calls it before timing the merges.
+ *  Elements are KeyAndIndex objects that are compared by their key only and
+ *   whose index records their original position, so that every test also
+ *   checks that equivalent elements end up in the right (i.e. stable) order.
+ *  Every TestCorrectnessOf...() function prints what failed and returns false
+ *   if a test fails.
+ */
+
+#ifndef SRC_MERGE_TEST_ADDITIONAL_INTERFACES_H_
+#define SRC_MERGE_TEST_ADDITIONAL_INTERFACES_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "../flat_sorted_vector.h"
+#include "../merge_without_buffer.h"
+#include "../merge_without_buffer_common.h"
+#include "../merge_without_buffer1.h"
+#include "../merge_without_buffer2.h"
+#include "../merge_without_buffer_async.h"
+#include "../merge_without_buffer_batch.h"
+#include "../merge_without_buffer_corank.h"
+#include "../merge_without_buffer_external_sort.h"
+#include "../merge_without_buffer_incremental.h"
+#include "../merge_without_buffer_lsm.h"
+#include "../merge_without_buffer_mmap.h"
+#include "../merge_without_buffer_networks.h"
+#include "../merge_without_buffer_partial.h"
+#include "../merge_without_buffer_partition.h"
+#include "../merge_without_buffer_records.h"
+#include "../merge_without_buffer_reduce.h"
+#include "../merge_without_buffer_rotate.h"
+#include "../merge_without_buffer_set_operations.h"
+#include "../merge_without_buffer_sort.h"
+#include "../merge_without_buffer_strings.h"
+#include "../merged_view.h"
+
+struct KeyAndIndex {
+  int key;
+  int index;
+
+  inline bool operator==(const KeyAndIndex &rhs) const {
+    return key == rhs.key && index == rhs.index;
+  }
+  inline bool operator!=(const KeyAndIndex &rhs) const {
+    return !(this->operator==(rhs));
+  }
+};
+
+struct KeyAndIndexLess {
+  inline bool operator()(const KeyAndIndex &lhs,
+                         const KeyAndIndex &rhs) const {
+    return lhs.key < rhs.key;
+  }
+};
+
+/* Helper function for the TestCorrectnessOf...() functions.
+ * Returns length elements whose keys are in [0, num_keys) and whose indices
+ *  are 0, 1, ..., length - 1.
+ */
+inline std::vector<KeyAndIndex> GetRandomKeysAndIndices(
+                                                    std::size_t length,
+                                                    int num_keys,
+                                                    std::mt19937 &generator) {
+  std::uniform_int_distribution<int> dist(0, num_keys - 1);
+  std::vector<KeyAndIndex> vec(length);
+  for (std::size_t i = 0; i < length; i++)
+    vec[i] = KeyAndIndex{dist(generator), static_cast<int>(i)};
+  return vec;
+}
+
+/* Helper function for the TestCorrectnessOf...() functions.
+ * Returns length elements that consist of two sorted lists, the first of
+ *  which has length_left elements. The indices increase from left to right
+ *  within each group of equivalent elements of each list.
+ */
+inline std::vector<KeyAndIndex> GetRandomSortedLists(
+                                                    std::size_t length_left,
+                                                    std::size_t length,
+                                                    int num_keys,
+                                                    std::mt19937 &generator) {
+  std::vector<KeyAndIndex> vec = GetRandomKeysAndIndices(length, num_keys,
+                                                         generator);
+  std::stable_sort(vec.begin(), vec.begin() + length_left, KeyAndIndexLess());
+  std::stable_sort(vec.begin() + length_left, vec.end(), KeyAndIndexLess());
+  return vec;
+}
+
+/* Helper function for the TestCorrectnessOf...() functions.
+ * Returns true if result == expected. Otherwise, it prints an error message
+ *  that starts with test_name and returns false.
+ */
+inline bool VerifyKeysAndIndices(const std::vector<KeyAndIndex> &result,
+                                 const std::vector<KeyAndIndex> &expected,
+                                 const std::string &test_name) {
+  if (result.size() != expected.size()) {
+    std::cout << test_name << " failed: the result has " << result.size()
+              << " elements instead of " << expected.size() << "."
+              << std::endl;
+    return false;
+  }
+  for (std::size_t i = 0; i < result.size(); i++) {
+    if (result[i] != expected[i]) {
+      std::cout << test_name << " failed: at position " << i << " the result"
+                << " is (key " << result[i].key << ", index "
+                << result[i].index << ") instead of (key " << expected[i].key
+                << ", index " << expected[i].index << ")." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeWithOutBuffer1(), MergeWithOutBuffer2(),
+ *  and MergeWithOutBuffer() merged random lists that they were given as raw
+ *  pointers (which are used as is) and as a built-in array (which decays to
+ *  a pointer) exactly like std::inplace_merge() did.
+ */
+inline bool TestCorrectnessOfMergesOfPointers(std::mt19937 &generator) {
+  const std::size_t kMaxLength = 2000;
+  KeyAndIndex array[kMaxLength];
+  for (std::size_t length = 0; length <= kMaxLength;
+       length += 1 + length / 4) {
+    for (int num_keys : { 2, 64, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                           generator);
+      auto expected = original;
+      std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                         expected.end(), KeyAndIndexLess());
+      for (int variant = 0; variant < 3; variant++) {
+        auto vec = original;
+        KeyAndIndex *start = vec.data();
+        if (variant == 0)
+          MergeWithOutBuffer1(start, start + length_left, start + length,
+                              KeyAndIndexLess());
+        else if (variant == 1)
+          MergeWithOutBuffer2(start, start + length_left, start + length,
+                              KeyAndIndexLess());
+        else
+          MergeWithOutBuffer(start, start + length_left, start + length,
+                             KeyAndIndexLess());
+        if (!VerifyKeysAndIndices(vec, expected, "Merging through pointers"))
+          return false;
+      }
+      std::copy(original.begin(), original.end(), array);
+      MergeWithOutBuffer1(array, array + length_left, array + length,
+                          KeyAndIndexLess());
+      if (!VerifyKeysAndIndices(std::vector<KeyAndIndex>(array,
+                      array + length), expected, "Merging a built-in array"))
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeWithOutBuffer1() and MergeWithOutBuffer2()
+ *  merged a very short list (of m = 1, 2, 3, ... elements) with a long list
+ *  of n = 10^4 elements, for which m * m * MWOB_UNBALANCED_MERGE_RATIO <= n
+ *  so that they call mwob_namespace::MergeUnbalanced_RAI(), exactly like
+ *  std::inplace_merge() did, both when the short list is the left list and
+ *  when it is the right list, and with and without duplicate keys on both
+ *  sides.
+ */
+inline bool TestCorrectnessOfUnbalancedMerges(std::mt19937 &generator) {
+  const std::size_t kLongLength = 10000;
+  for (std::size_t short_length : { 1, 2, 3, 5, 8, 13, 40, 50 }) {
+    for (int num_keys : { 3, 50, 1 << 20 }) {
+      for (int is_short_left = 0; is_short_left < 2; is_short_left++) {
+        for (int trial = 0; trial < 4; trial++) {
+          std::size_t length = short_length + kLongLength;
+          std::size_t length_left = is_short_left ? short_length
+                                                  : kLongLength;
+          auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                               generator);
+          auto expected = original;
+          std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                             expected.end(), KeyAndIndexLess());
+          auto vec = original;
+          MergeWithOutBuffer1(vec.begin(), vec.begin() + length_left,
+                              vec.end(), KeyAndIndexLess());
+          if (!VerifyKeysAndIndices(vec, expected,
+                          "MergeWithOutBuffer1() of unbalanced lists"))
+            return false;
+          vec = original;
+          MergeWithOutBuffer2(vec.begin(), vec.begin() + length_left,
+                              vec.end(), KeyAndIndexLess());
+          if (!VerifyKeysAndIndices(vec, expected,
+                          "MergeWithOutBuffer2() of unbalanced lists"))
+            return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Helper function for TestCorrectnessOfMergeNetworks().
+ * Returns true if and only if the merge network for the lengths of left and
+ *  right (called through mwob_namespace::MergeByNetwork()'s table) merged
+ *  left and right (which are sorted according to comp) exactly like
+ *  std::merge() did.
+ */
+template<typename Compare>
+inline bool VerifyMergeNetwork(const std::vector<int> &left,
+                               const std::vector<int> &right,
+                               Compare comp) {
+  std::vector<int> expected;
+  std::merge(left.begin(), left.end(), right.begin(), right.end(),
+             std::back_inserter(expected), comp);
+  std::vector<int> vec(left);
+  vec.insert(vec.end(), right.begin(), right.end());
+  mwob_namespace::MergeByNetwork(vec.begin(),
+                                 static_cast<std::ptrdiff_t>(left.size()),
+                                 static_cast<std::ptrdiff_t>(right.size()),
+                                 comp);
+  if (vec != expected) {
+    std::cout << "The merge network for lengths " << left.size() << " and "
+              << right.size() << " failed." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/* Returns true if and only if the merge network of every shape (L, R) with
+ *  1 <= L, R <= MWOB_MERGE_NETWORK_MAX_LENGTH merged, with both std::less
+ *  and std::greater, every sorted list of 0s and 1s (which, by the 0-1
+ *  principle, proves that it merges all inputs) and random lists of ints.
+ */
+inline bool TestCorrectnessOfMergeNetworks(std::mt19937 &generator) {
+  const std::size_t kMaxLength = MWOB_MERGE_NETWORK_MAX_LENGTH;
+  for (std::size_t length_left = 1; length_left <= kMaxLength; length_left++) {
+    for (std::size_t length_right = 1; length_right <= kMaxLength;
+         length_right++) {
+      //Every sorted list of 0s and 1s.
+      for (std::size_t num_left_ones = 0; num_left_ones <= length_left;
+           num_left_ones++) {
+        for (std::size_t num_right_ones = 0; num_right_ones <= length_right;
+             num_right_ones++) {
+          std::vector<int> left(length_left, 0), right(length_right, 0);
+          std::fill(left.end() - num_left_ones, left.end(), 1);
+          std::fill(right.end() - num_right_ones, right.end(), 1);
+          if (!VerifyMergeNetwork(left, right, std::less<int>()))
+            return false;
+          std::reverse(left.begin(), left.end());
+          std::reverse(right.begin(), right.end());
+          if (!VerifyMergeNetwork(left, right, std::greater<int>()))
+            return false;
+        }
+      }
+      //Random lists.
+      for (int trial = 0; trial < 20; trial++) {
+        std::uniform_int_distribution<int> dist(-3, trial % 2 == 0 ? 3
+                                                                   : 1000);
+        std::vector<int> left(length_left), right(length_right);
+        for (int &value : left)
+          value = dist(generator);
+        for (int &value : right)
+          value = dist(generator);
+        std::sort(left.begin(), left.end());
+        std::sort(right.begin(), right.end());
+        if (!VerifyMergeNetwork(left, right, std::less<int>()))
+          return false;
+        std::reverse(left.begin(), left.end());
+        std::reverse(right.begin(), right.end());
+        if (!VerifyMergeNetwork(left, right, std::greater<int>()))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if, for every k, CoRank() (with both the four and
+ *  the three iterator overloads) returned the numbers of left and right
+ *  elements among the first k elements of the std::merge() of random lists
+ *  (whose left elements precede equivalent right elements) and
+ *  ElementOfMergeAt() returned the element at position k of it.
+ */
+inline bool TestCorrectnessOfCoRank(std::mt19937 &generator) {
+  typedef std::vector<KeyAndIndex>::iterator Iterator;
+  for (std::size_t length = 0; length <= 600; length += 1 + length / 3) {
+    for (int num_keys : { 1, 3, 20, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto vec = GetRandomSortedLists(length_left, length, num_keys,
+                                      generator);
+      std::vector<KeyAndIndex> left(vec.begin(), vec.begin() + length_left);
+      std::vector<KeyAndIndex> right(vec.begin() + length_left, vec.end());
+      std::vector<KeyAndIndex> expected;
+      std::merge(left.begin(), left.end(), right.begin(), right.end(),
+                 std::back_inserter(expected), KeyAndIndexLess());
+      //The indices of the left elements are less than length_left.
+      std::ptrdiff_t num_left = 0;
+      for (std::ptrdiff_t k = 0; k <= static_cast<std::ptrdiff_t>(length);
+           k++) {
+        std::pair<std::ptrdiff_t, std::ptrdiff_t> expected_split(num_left,
+                                                                 k - num_left);
+        auto split = CoRank(left.begin(), left.end(), right.begin(),
+                            right.end(), k, KeyAndIndexLess());
+        Iterator start_right = vec.begin() + length_left;
+        auto split_of_adjacent = CoRank(vec.begin(), start_right, vec.end(),
+                                        k, KeyAndIndexLess());
+        if (split != expected_split || split_of_adjacent != expected_split) {
+          std::cout << "CoRank() failed: for k = " << k << " it returned ("
+                    << split.first << ", " << split.second << ") instead of ("
+                    << expected_split.first << ", " << expected_split.second
+                    << ")." << std::endl;
+          return false;
+        }
+        if (k == static_cast<std::ptrdiff_t>(length))
+          break ;
+        Iterator element = ElementOfMergeAt(left.begin(), left.end(),
+                               right.begin(), right.end(), k,
+                               KeyAndIndexLess());
+        if (*element != expected[k]) {
+          std::cout << "ElementOfMergeAt() failed: for n = " << k
+                    << " it returned (key " << element->key << ", index "
+                    << element->index << ") instead of (key "
+                    << expected[k].key << ", index " << expected[k].index
+                    << ")." << std::endl;
+          return false;
+        }
+        if (expected[k].index < static_cast<int>(length_left))
+          num_left++;
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if iterating forwards and backwards over, and
+ *  indexing into, copies of merged_views of random lists (whose originals
+ *  were destroyed or overwritten) visited the elements of the std::merge()
+ *  of the lists in its order.
+ */
+inline bool TestCorrectnessOfMergedView(std::mt19937 &generator) {
+  typedef merged_view<std::vector<KeyAndIndex>::const_iterator,
+                      KeyAndIndexLess> View;
+  std::vector<KeyAndIndex> empty;
+  for (std::size_t length = 0; length <= 600; length += 1 + length / 3) {
+    for (int num_keys : { 1, 3, 20, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto vec = GetRandomSortedLists(length_left, length, num_keys,
+                                      generator);
+      const std::vector<KeyAndIndex> left(vec.begin(),
+                                          vec.begin() + length_left);
+      const std::vector<KeyAndIndex> right(vec.begin() + length_left,
+                                           vec.end());
+      std::vector<KeyAndIndex> expected;
+      std::merge(left.begin(), left.end(), right.begin(), right.end(),
+                 std::back_inserter(expected), KeyAndIndexLess());
+      View view(empty.cbegin(), empty.cend(), empty.cbegin(), empty.cend());
+      View::const_iterator it;
+      {
+        View original(left.begin(), left.end(), right.begin(), right.end());
+        View copy(original);
+        view = copy;
+        it = original.begin();
+      }
+      std::vector<KeyAndIndex> forwards(it, view.end());
+      std::vector<KeyAndIndex> backwards;
+      for (auto back = view.end(); back != view.begin(); )
+        backwards.push_back(*--back);
+      std::reverse(backwards.begin(), backwards.end());
+      std::vector<KeyAndIndex> indexed;
+      for (std::size_t k = 0; k < view.size(); k++)
+        indexed.push_back(k % 2 == 0 ? view[k] : *(view.begin() + k));
+      if (!VerifyKeysAndIndices(forwards, expected,
+                                "merged_view (forwards)")
+          || !VerifyKeysAndIndices(backwards, expected,
+                                   "merged_view (backwards)")
+          || !VerifyKeysAndIndices(indexed, expected,
+                                   "merged_view (indexing)"))
+        return false;
+      if (view.end() - view.begin() != static_cast<std::ptrdiff_t>(length)) {
+        std::cout << "merged_view failed: end() - begin() is "
+                  << view.end() - view.begin() << " instead of " << length
+                  << "." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if, for several k (including 0 and the length),
+ *  PartialMergeWithOutBuffer() placed the first k elements of the merge of
+ *  random lists exactly like std::inplace_merge() did, and the merge was
+ *  then finished as its header comment describes.
+ */
+inline bool TestCorrectnessOfPartialMergeWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  typedef std::vector<KeyAndIndex>::iterator Iterator;
+  for (std::size_t length = 0; length <= 2000; length += 1 + length / 3) {
+    for (int num_keys : { 1, 3, 20, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto vec = GetRandomSortedLists(length_left, length, num_keys,
+                                      generator);
+      auto expected = vec;
+      std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                         expected.end(), KeyAndIndexLess());
+      std::ptrdiff_t n = static_cast<std::ptrdiff_t>(length);
+      std::ptrdiff_t random_k = static_cast<std::ptrdiff_t>(generator()
+                                                            % (length + 1));
+      for (std::ptrdiff_t k : { std::ptrdiff_t(0), std::ptrdiff_t(1),
+                                random_k, n / 2, n - 1, n }) {
+        if (k < 0 || k > n)
+          continue ;
+        auto partial = vec;
+        Iterator start_left = partial.begin();
+        Iterator start_right = start_left + length_left;
+        Iterator middle = PartialMergeWithOutBuffer(start_left, start_right,
+                                                    partial.end(), k,
+                                                    KeyAndIndexLess());
+        std::vector<KeyAndIndex> prefix(start_left, start_left + k);
+        std::vector<KeyAndIndex> expected_prefix(expected.begin(),
+                                                 expected.begin() + k);
+        if (!VerifyKeysAndIndices(prefix, expected_prefix,
+                                  "PartialMergeWithOutBuffer()"))
+          return false;
+        if (start_left + k < start_right)
+          RotateWithOutBuffer(start_left + k, start_right, middle);
+        MergeWithOutBuffer1(start_left + k, middle, partial.end(),
+                            KeyAndIndexLess());
+        if (!VerifyKeysAndIndices(partial, expected,
+                                  "PartialMergeWithOutBuffer() (finished)"))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Helper function for TestCorrectnessOfBlockExchanges().
+ * Returns 0, a few small lengths, and the lengths of blocks of values of
+ *  size value_size whose sizes in bytes are around MWOB_TILED_SWAP_MIN_BYTES,
+ *  MWOB_ROTATE_STACK_BYTES, and MWOB_SWAP_TILE_BYTES or around twice or
+ *  three times these (so that the shorter block of a rotation crosses them).
+ */
+inline std::vector<std::size_t> GetLengthsAroundBlockExchangeThresholds(
+                                                      std::size_t value_size) {
+  std::vector<std::size_t> lengths({ 0, 1, 2, 3, 5, 17 });
+  for (std::size_t num_bytes : { std::size_t(MWOB_TILED_SWAP_MIN_BYTES),
+                                 std::size_t(MWOB_ROTATE_STACK_BYTES),
+                                 std::size_t(MWOB_SWAP_TILE_BYTES) }) {
+    std::size_t length = num_bytes / value_size;
+    if (length == 0)
+      continue ;
+    for (std::size_t length_around : { length - 1, length, length + 1,
+                                       2 * length + 1, 3 * length + 2 })
+      lengths.push_back(length_around);
+  }
+  return lengths;
+}
+
+/* Helper function for TestCorrectnessOfBlockExchanges().
+ * Returns true if and only if RotateWithOutBuffer() and RotateByCycles_RAI()
+ *  (and, if T is trivially copyable, RotateBlocksTiled_ptr()) rotated
+ *  the length values that start offset values into a vector by 0, 1,
+ *  length - 1, length / 2, and by shifts that are coprime and not coprime
+ *  to length exactly like std::rotate() did, and (if T is trivially
+ *  copyable) SwapBlocksTiled_ptr() swapped their first and last length / 2
+ *  values exactly like std::swap_ranges() did.
+ */
+template<typename T, typename MakeValue>
+inline bool VerifyBlockExchanges(std::size_t length, std::size_t offset,
+                                 MakeValue make_value,
+                                 const std::string &type_name) {
+  std::vector<T> values(offset + length);
+  for (std::size_t i = 0; i < values.size(); i++)
+    values[i] = make_value(i);
+  std::vector<std::size_t> shifts({ 0 });
+  if (length > 0) {
+    for (std::size_t shift : { std::size_t(1), length - 1, length / 2 })
+      shifts.push_back(shift);
+    bool is_coprime_found = false, is_not_coprime_found = false;
+    for (std::size_t shift = length / 3 + 1; shift < length; shift++) {
+      bool is_coprime = std::gcd(length, shift) == 1;
+      if (is_coprime ? is_coprime_found : is_not_coprime_found)
+        continue ;
+      shifts.push_back(shift);
+      (is_coprime ? is_coprime_found : is_not_coprime_found) = true;
+    }
+  }
+  //Both the values and the returned iterator must be those of std::rotate().
+  auto verify = [&](const std::string &name, bool is_correct,
+                    std::size_t shift) {
+    if (!is_correct)
+      std::cout << name << " failed on " << length << " " << type_name
+                << "s starting " << offset << " values into a vector with a"
+                << " shift of " << shift << "." << std::endl;
+    return is_correct;
+  };
+  for (std::size_t shift : shifts) {
+    std::vector<T> expected = values;
+    auto expected_new_start = std::rotate(expected.begin() + offset,
+                                          expected.begin() + offset + shift,
+                                          expected.end()) - expected.begin();
+    std::vector<T> rotated = values;
+    T *start = rotated.data() + offset;
+    T *new_start = RotateWithOutBuffer(start, start + shift, start + length);
+    if (!verify("RotateWithOutBuffer()", rotated == expected
+                && new_start - rotated.data() == expected_new_start, shift))
+      return false;
+    rotated = values;
+    auto new_start_of_cycles = mwob_namespace::RotateByCycles_RAI(
+                                   rotated.begin() + offset,
+                                   rotated.begin() + offset + shift,
+                                   rotated.end());
+    if (!verify("RotateByCycles_RAI()", rotated == expected
+                && new_start_of_cycles - rotated.begin() == expected_new_start,
+                shift))
+      return false;
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      rotated = values;
+      start = rotated.data() + offset;
+      new_start = mwob_namespace::RotateBlocksTiled_ptr(start, start + shift,
+                                                        start + length);
+      if (!verify("RotateBlocksTiled_ptr()", rotated == expected
+                  && new_start - rotated.data() == expected_new_start, shift))
+        return false;
+    }
+  }
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    std::size_t half = length / 2;
+    std::vector<T> expected = values;
+    std::swap_ranges(expected.begin() + offset,
+                     expected.begin() + offset + half, expected.end() - half);
+    std::vector<T> swapped = values;
+    T *start = swapped.data() + offset;
+    mwob_namespace::SwapBlocksTiled_ptr(start, start + half,
+                                        start + (length - half));
+    if (swapped != expected) {
+      std::cout << "SwapBlocksTiled_ptr() failed on two blocks of " << half
+                << " " << type_name << "s starting " << offset << " and "
+                << offset + (length - half) << " values into a vector."
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if RotateWithOutBuffer(), RotateByCycles_RAI(),
+ *  RotateBlocksTiled_ptr(), and SwapBlocksTiled_ptr() rotated and swapped
+ *  random bytes, ints, and std::strings starting at aligned and unaligned
+ *  addresses exactly like std::rotate() and std::swap_ranges() did (see
+ *  VerifyBlockExchanges()), including blocks that cross the tiling
+ *  thresholds and blocks larger than MWOB_LLC_SIZE_BYTES, which are
+ *  prefetched (and, if MWOB_USE_NON_TEMPORAL_STORES is set, written by
+ *  non-temporal stores).
+ */
+inline bool TestCorrectnessOfBlockExchanges(std::mt19937 &generator) {
+  auto make_byte = [&generator](std::size_t) {
+    return static_cast<unsigned char>(generator());
+  };
+  auto make_int = [&generator](std::size_t) {
+    return static_cast<int>(generator());
+  };
+  auto make_string = [&generator](std::size_t i) {
+    return std::to_string(i) + std::string(generator() % 24, 'x');
+  };
+  for (std::size_t offset = 0; offset < 4; offset++) {
+    for (std::size_t length :
+             GetLengthsAroundBlockExchangeThresholds(sizeof(unsigned char)))
+      if (!VerifyBlockExchanges<unsigned char>(length, offset, make_byte,
+                                               "byte"))
+        return false;
+    for (std::size_t length : GetLengthsAroundBlockExchangeThresholds(
+                                  sizeof(int)))
+      if (!VerifyBlockExchanges<int>(length, offset, make_int, "int"))
+        return false;
+    for (std::size_t length : GetLengthsAroundBlockExchangeThresholds(
+                                  sizeof(std::string)))
+      if (!VerifyBlockExchanges<std::string>(length, offset, make_string,
+                                             "std::string"))
+        return false;
+  }
+  //Blocks larger than the last level cache, with equal and with different
+  // alignments modulo 16.
+  const std::size_t num_bytes = MWOB_LLC_SIZE_BYTES + 3;
+  auto byte_at = [](std::size_t i) {
+    return static_cast<unsigned char>((i * 2654435761u) >> 13);
+  };
+  std::vector<unsigned char> block1(num_bytes + 2), block2(num_bytes + 2);
+  for (std::size_t offset2 : { 1, 2 }) {
+    for (std::size_t i = 0; i < num_bytes; i++) {
+      block1[1 + i] = byte_at(i);
+      block2[offset2 + i] = static_cast<unsigned char>(byte_at(i) ^ 0xa5);
+    }
+    mwob_namespace::SwapBlocksTiled_ptr(block1.data() + 1,
+                                        block1.data() + 1 + num_bytes,
+                                        block2.data() + offset2);
+    for (std::size_t i = 0; i < num_bytes; i++) {
+      if (block1[1 + i] != static_cast<unsigned char>(byte_at(i) ^ 0xa5)
+          || block2[offset2 + i] != byte_at(i)) {
+        std::cout << "SwapBlocksTiled_ptr() failed on blocks of " << num_bytes
+                  << " bytes at byte " << i << "." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if StableSortWithOutBuffer() sorted random vectors
+ *  exactly like std::stable_sort() did.
+ */
+inline bool TestCorrectnessOfStableSortWithOutBuffer(std::mt19937 &generator) {
+  for (std::size_t length = 0; length <= 600; length += 1 + length / 8) {
+    for (int num_keys : { 1, 4, 1 << 20 }) {
+      auto vec = GetRandomKeysAndIndices(length, num_keys, generator);
+      auto expected = vec;
+      std::stable_sort(expected.begin(), expected.end(), KeyAndIndexLess());
+      StableSortWithOutBuffer(vec.begin(), vec.end(), KeyAndIndexLess());
+      if (!VerifyKeysAndIndices(vec, expected, "StableSortWithOutBuffer()"))
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if a flat_sorted_vector that receives random
+ *  insertions, look ups, and erasures agrees with a std::vector that is kept
+ *  stably sorted, including the elements that the iterators returned by
+ *  find() refer to.
+ */
+inline bool TestCorrectnessOfFlatSortedVector(std::mt19937 &generator) {
+  const std::string test_name = "flat_sorted_vector";
+  typedef flat_sorted_vector<KeyAndIndex, KeyAndIndexLess> FlatSortedVector;
+  {
+    //find() must not return an iterator into the unsorted tail, which end()
+    // and erase() would reorder.
+    FlatSortedVector fsv(KeyAndIndexLess(), 8);
+    int index = 0;
+    for (int key : { 50, 10, 40, 30, 20 })
+      fsv.insert(KeyAndIndex{key, index++});
+    auto it = fsv.find(KeyAndIndex{10, -1});
+    if (it == fsv.end() || it->key != 10) {
+      std::cout << test_name << " failed: find() returned an iterator that"
+                << " does not refer to the element that was found."
+                << std::endl;
+      return false;
+    }
+    fsv.erase(fsv.find(KeyAndIndex{10, -1}));
+    if (fsv.contains(KeyAndIndex{10, -1}) || fsv.size() != 4) {
+      std::cout << test_name << " failed: erase(find(value)) did not erase"
+                << " value." << std::endl;
+      return false;
+    }
+  }
+  std::uniform_int_distribution<int> operation_dist(0, 9);
+  for (std::size_t max_tail_length : { 1, 7, 64 }) {
+    FlatSortedVector fsv(KeyAndIndexLess(), max_tail_length);
+    std::vector<KeyAndIndex> expected;
+    const int num_keys = 40;
+    std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+    for (int index = 0; index < 3000; index++) {
+      KeyAndIndex value{key_dist(generator), index};
+      int operation = operation_dist(generator);
+      if (operation < 6) {
+        fsv.insert(value);
+        expected.insert(std::upper_bound(expected.begin(), expected.end(),
+                                         value, KeyAndIndexLess()), value);
+      } else if (operation == 6) {
+        auto it = fsv.find(value);
+        auto expected_it = std::lower_bound(expected.begin(), expected.end(),
+                                            value, KeyAndIndexLess());
+        bool is_in_expected = expected_it != expected.end() &&
+                              expected_it->key == value.key;
+        if ((it != fsv.end()) != is_in_expected ||
+            (is_in_expected && *it != *expected_it)) {
+          std::cout << test_name << " failed: find() of key " << value.key
+                    << " did not return its first occurrence." << std::endl;
+          return false;
+        }
+        if (is_in_expected) {
+          fsv.erase(it);
+          expected.erase(expected_it);
+        }
+      } else if (operation == 7) {
+        auto range = std::equal_range(expected.begin(), expected.end(), value,
+                                      KeyAndIndexLess());
+        std::size_t count = static_cast<std::size_t>(range.second
+                                                     - range.first);
+        if (fsv.count(value) != count || fsv.contains(value) != (count > 0)) {
+          std::cout << test_name << " failed: count() or contains() of key "
+                    << value.key << " is wrong." << std::endl;
+          return false;
+        }
+      } else if (operation == 8) {
+        auto range = std::equal_range(expected.begin(), expected.end(), value,
+                                      KeyAndIndexLess());
+        std::size_t count = static_cast<std::size_t>(range.second
+                                                     - range.first);
+        expected.erase(range.first, range.second);
+        if (fsv.erase(value) != count) {
+          std::cout << test_name << " failed: erase() of key " << value.key
+                    << " returned the wrong count." << std::endl;
+          return false;
+        }
+      } else {
+        std::vector<KeyAndIndex> result(fsv.begin(), fsv.end());
+        if (!VerifyKeysAndIndices(result, expected, test_name))
+          return false;
+      }
+    }
+    std::vector<KeyAndIndex> result(fsv.begin(), fsv.end());
+    if (!VerifyKeysAndIndices(result, expected, test_name))
+      return false;
+  }
+  return true;
+}
+
+/* Returns true if and only if mwob_namespace::MergeWatchdog trips (and stays
+ *  tripped) once either of its limits is exceeded and the recursive merges,
+ *  when handed a watchdog that has tripped, merge random lists by
+ *  MergeByRotations() exactly like std::inplace_merge() did (i.e. stably).
+ */
+inline bool TestCorrectnessOfMergeWatchdog(std::mt19937 &generator) {
+  const std::string test_name = "MergeWatchdog";
+  {
+    mwob_namespace::MergeWatchdog watchdog(1000);
+    if (watchdog.ShouldFallBack(0, watchdog.BudgetLimit()) ||
+        !watchdog.ShouldFallBack(0, 1) || !watchdog.ShouldFallBack(0, 0)) {
+      std::cout << test_name << " failed: it did not trip (and stay tripped)"
+                << " once its subproblem size budget was exceeded."
+                << std::endl;
+      return false;
+    }
+    mwob_namespace::MergeWatchdog depth_watchdog(1000);
+    if (depth_watchdog.ShouldFallBack(depth_watchdog.DepthLimit(), 0) ||
+        !depth_watchdog.ShouldFallBack(depth_watchdog.DepthLimit() + 1, 0) ||
+        !depth_watchdog.ShouldFallBack(0, 0)) {
+      std::cout << test_name << " failed: it did not trip (and stay tripped)"
+                << " once its depth limit was exceeded." << std::endl;
+      return false;
+    }
+  }
+  typedef std::vector<KeyAndIndex>::iterator Iterator;
+  typedef std::list<KeyAndIndex>::iterator ListIterator;
+  typedef std::ptrdiff_t Distance;
+  typedef mwob_namespace::ComplementCompare<KeyAndIndexLess>
+                                                           CompareLessOrEqual;
+  KeyAndIndexLess comp;
+  CompareLessOrEqual comp_le(comp);
+  for (std::size_t length = 2; length <= 2000; length += 1 + length / 4) {
+    for (int num_keys : { 3, 1 << 20 }) {
+      std::size_t length_left = 1 + generator() % (length - 1);
+      auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                           generator);
+      auto expected = original;
+      std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                         expected.end(), comp);
+      for (int variant = 1; variant <= 3; variant++) {
+        auto vec = original;
+        std::list<KeyAndIndex> list(original.begin(), original.end());
+        mwob_namespace::MergeWatchdog watchdog(length);
+        watchdog.ShouldFallBack(watchdog.DepthLimit() + 1, 0);
+        Iterator start_right = vec.begin() + length_left;
+        Distance length_l = static_cast<Distance>(length_left);
+        Distance length_r = static_cast<Distance>(length - length_left);
+        if (variant == 1) {
+          merge_without_buffer_1_namespace::MergeWithOutBuffer1_recursive_RAI<
+              Iterator, KeyAndIndexLess, Distance, CompareLessOrEqual,
+              KeyAndIndex>(vec.begin(), start_right, vec.end(), length_l,
+                  length_r, comp, comp_le,
+                  merge_without_buffer_1_namespace::ThreeValue::Unknown,
+                  merge_without_buffer_1_namespace::ThreeValue::Unknown,
+                  watchdog, 0);
+        } else if (variant == 2) {
+          merge_without_buffer_2_namespace::MergeWithOutBuffer2_recursive_RAI<
+              Iterator, KeyAndIndexLess, Distance, CompareLessOrEqual,
+              KeyAndIndex>(vec.begin(), start_right, vec.end(), length_l,
+                  length_r, comp, comp_le,
+                  merge_without_buffer_2_namespace::ThreeValue::Unknown,
+                  merge_without_buffer_2_namespace::ThreeValue::Unknown,
+                  merge_without_buffer_2_namespace::ThreeValue::Unknown,
+                  merge_without_buffer_2_namespace::ThreeValue::Unknown,
+                  watchdog, 0);
+        } else {
+          ListIterator list_start_right = list.begin();
+          std::advance(list_start_right, length_left);
+          merge_without_buffer_1_namespace::MergeWithOutBuffer1_recursive_bi<
+              ListIterator, KeyAndIndexLess, Distance, CompareLessOrEqual,
+              KeyAndIndex>(list.begin(), list_start_right, list.end(),
+                  length_l, length_r, comp, comp_le,
+                  merge_without_buffer_1_namespace::ThreeValue::Unknown,
+                  merge_without_buffer_1_namespace::ThreeValue::Unknown,
+                  watchdog, 0);
+          vec.assign(list.begin(), list.end());
+        }
+        if (!VerifyKeysAndIndices(vec, expected, test_name + " fallback of "
+                                  "variant " + std::to_string(variant)))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if SetUnionWithOutBuffer(),
+ *  SetIntersectionWithOutBuffer(), and SetDifferenceWithOutBuffer() kept
+ *  exactly the elements, in the order, that std::unique() applied to the
+ *  stable merge, std::set_intersection(), and std::set_difference() (resp.)
+ *  did on random lists.
+ */
+inline bool TestCorrectnessOfSetOperationsWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  KeyAndIndexLess comp;
+  auto is_equivalent = [comp](const KeyAndIndex &lhs,
+                              const KeyAndIndex &rhs) -> bool {
+    return !comp(lhs, rhs) && !comp(rhs, lhs);
+  };
+  for (std::size_t length = 1; length <= 1500; length += 1 + length / 4) {
+    for (int num_keys : { 2, 16, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                           generator);
+      auto start_right = original.begin() + length_left;
+
+      auto expected = original;
+      std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                         expected.end(), comp);
+      expected.erase(std::unique(expected.begin(), expected.end(),
+                                 is_equivalent), expected.end());
+      auto vec = original;
+      vec.erase(SetUnionWithOutBuffer(vec.begin(), vec.begin() + length_left,
+                                      vec.end(), comp), vec.end());
+      if (!VerifyKeysAndIndices(vec, expected, "SetUnionWithOutBuffer()"))
+        return false;
+
+      expected.clear();
+      std::set_intersection(original.begin(), start_right, start_right,
+                            original.end(), std::back_inserter(expected), comp);
+      vec = original;
+      vec.erase(SetIntersectionWithOutBuffer(vec.begin(),
+                    vec.begin() + length_left, vec.end(), comp), vec.end());
+      if (!VerifyKeysAndIndices(vec, expected,
+                                "SetIntersectionWithOutBuffer()"))
+        return false;
+
+      expected.clear();
+      std::set_difference(original.begin(), start_right, start_right,
+                          original.end(), std::back_inserter(expected), comp);
+      vec = original;
+      vec.erase(SetDifferenceWithOutBuffer(vec.begin(),
+                    vec.begin() + length_left, vec.end(), comp), vec.end());
+      if (!VerifyKeysAndIndices(vec, expected, "SetDifferenceWithOutBuffer()"))
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeReduceWithOutBuffer() folded every group
+ *  of equivalent elements of random lists into one element that lists the
+ *  group's indices in the order of the stable merge. Since concatenation is
+ *  associative but not commutative, this checks the order in which the
+ *  records of each group are folded.
+ */
+inline bool TestCorrectnessOfMergeReduceWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  struct KeyAndIndices {
+    int key;
+    std::vector<int> indices;
+  };
+  auto by_key = [](const KeyAndIndices &lhs,
+                   const KeyAndIndices &rhs) -> bool {
+    return lhs.key < rhs.key;
+  };
+  auto concatenate = [](KeyAndIndices &into, KeyAndIndices &&from) {
+    into.indices.insert(into.indices.end(), from.indices.begin(),
+                        from.indices.end());
+  };
+  for (std::size_t length = 1; length <= 1500; length += 1 + length / 4) {
+    for (int num_keys : { 1, 4, 64, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                           generator);
+      auto merged = original;
+      std::inplace_merge(merged.begin(), merged.begin() + length_left,
+                         merged.end(), KeyAndIndexLess());
+      std::vector<KeyAndIndices> expected;
+      for (const KeyAndIndex &element : merged) {
+        if (expected.empty() || expected.back().key != element.key)
+          expected.push_back(KeyAndIndices{element.key, {}});
+        expected.back().indices.push_back(element.index);
+      }
+
+      std::vector<KeyAndIndices> vec;
+      for (const KeyAndIndex &element : original)
+        vec.push_back(KeyAndIndices{element.key, { element.index }});
+      auto new_end = MergeReduceWithOutBuffer(vec.begin(),
+                         vec.begin() + length_left, vec.end(), by_key,
+                         concatenate);
+      vec.erase(new_end, vec.end());
+      if (vec.size() != expected.size()) {
+        std::cout << "MergeReduceWithOutBuffer() failed: it returned "
+                  << vec.size() << " elements instead of " << expected.size()
+                  << "." << std::endl;
+        return false;
+      }
+      for (std::size_t i = 0; i < vec.size(); i++) {
+        if (vec[i].key != expected[i].key
+            || vec[i].indices != expected[i].indices) {
+          std::cout << "MergeReduceWithOutBuffer() failed: the element at "
+                    << "position " << i << " has key " << vec[i].key
+                    << " instead of " << expected[i].key << " or its indices"
+                    << " are not in the order of the stable merge."
+                    << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if StablePartitionWithOutBuffer() partitioned
+ *  random std::vectors (which are partitioned through the stack array and by
+ *  rotations) and std::lists exactly as std::stable_partition() did, returned
+ *  the same partition point, and applied pred exactly once to each element.
+ */
+inline bool TestCorrectnessOfStablePartitionWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  std::size_t num_calls = 0;
+  int threshold = 0;
+  auto pred = [&num_calls, &threshold](const KeyAndIndex &element) -> bool {
+    num_calls++;
+    return element.key < threshold;
+  };
+  //Subranges of more than MWOB_PARTITION_STACK_BYTES bytes are partitioned
+  // by rotations.
+  std::size_t max_length = 4 * MWOB_PARTITION_STACK_BYTES
+                           / sizeof(KeyAndIndex) + 100;
+  for (std::size_t length = 0; length <= max_length;
+       length += 1 + length / 8) {
+    for (int percent_true : { 0, 10, 50, 90, 100 }) {
+      threshold = percent_true;
+      auto original = GetRandomKeysAndIndices(length, 100, generator);
+      auto expected = original;
+      auto expected_point = std::stable_partition(expected.begin(),
+                                                  expected.end(), pred);
+      std::size_t expected_length_true = static_cast<std::size_t>(
+                                          expected_point - expected.begin());
+
+      auto vec = original;
+      num_calls = 0;
+      auto point = StablePartitionWithOutBuffer(vec.begin(), vec.end(), pred);
+      if (!VerifyKeysAndIndices(vec, expected,
+                      "StablePartitionWithOutBuffer() on a std::vector"))
+        return false;
+      if (static_cast<std::size_t>(point - vec.begin()) != expected_length_true
+          || num_calls != length) {
+        std::cout << "StablePartitionWithOutBuffer() on a std::vector failed:"
+                  << " it returned the wrong partition point or did not apply"
+                  << " pred exactly once to each element." << std::endl;
+        return false;
+      }
+
+      std::list<KeyAndIndex> list(original.begin(), original.end());
+      num_calls = 0;
+      auto list_point = StablePartitionWithOutBuffer(list.begin(), list.end(),
+                                                     pred);
+      if (!VerifyKeysAndIndices(std::vector<KeyAndIndex>(list.begin(),
+                      list.end()), expected,
+                      "StablePartitionWithOutBuffer() on a std::list"))
+        return false;
+      if (static_cast<std::size_t>(std::distance(list.begin(), list_point))
+          != expected_length_true || num_calls != length) {
+        std::cout << "StablePartitionWithOutBuffer() on a std::list failed:"
+                  << " it returned the wrong partition point or did not apply"
+                  << " pred exactly once to each element." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Helper function for TestCorrectnessOfMergeWithOutBufferCounting().
+ * Returns true if and only if MergeWithOutBufferCounting() and the overload
+ *  of MergeWithOutBuffer() that takes an IntegralKeyRange both merged the
+ *  lists [0, length_left) and [length_left, N) of values (which are sorted
+ *  according to comp) into the list that std::inplace_merge() produced.
+ */
+template<typename Container, typename KeyType, typename Compare>
+inline bool VerifyMergeWithOutBufferCounting(
+                            const std::vector<KeyType> &values,
+                            std::size_t length_left,
+                            IntegralKeyRange<KeyType> key_range,
+                            Compare comp,
+                            const std::string &test_name) {
+  std::vector<KeyType> expected = values;
+  std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                     expected.end(), comp);
+  for (int use_overload = 0; use_overload < 2; use_overload++) {
+    Container container(values.begin(), values.end());
+    auto start_right = container.begin();
+    std::advance(start_right, length_left);
+    if (use_overload)
+      MergeWithOutBuffer(container.begin(), start_right, container.end(),
+                         comp, key_range);
+    else
+      MergeWithOutBufferCounting(container.begin(), start_right,
+                                 container.end(), key_range, comp);
+    if (!std::equal(container.begin(), container.end(), expected.begin())) {
+      std::cout << (use_overload ? "MergeWithOutBuffer()"
+                                 : "MergeWithOutBufferCounting()")
+                << " failed on " << test_name << " of length "
+                << values.size() << "." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeWithOutBufferCounting() and the overload
+ *  of MergeWithOutBuffer() that takes an IntegralKeyRange merged random lists
+ *  of integers correctly, both when they merge by counting and when they fall
+ *  back to MergeWithOutBuffer1() because the key range is too large, the hint
+ *  is wrong (so that the table overflows), the comparison function is not
+ *  std::less or std::greater, or the iterators are not random access.
+ * Since equivalent integers are equal, there are no indices to check.
+ */
+inline bool TestCorrectnessOfMergeWithOutBufferCounting(
+                                                    std::mt19937 &generator) {
+  auto get_values = [&generator](std::size_t length, std::size_t length_left,
+                                 int min, int max, bool is_decreasing) {
+    std::uniform_int_distribution<int> dist(min, max);
+    std::vector<int> values(length);
+    for (int &value : values)
+      value = dist(generator);
+    auto start_right = values.begin() + length_left;
+    if (is_decreasing) {
+      std::sort(values.begin(), start_right, std::greater<int>());
+      std::sort(start_right, values.end(), std::greater<int>());
+    } else {
+      std::sort(values.begin(), start_right);
+      std::sort(start_right, values.end());
+    }
+    return values;
+  };
+  auto int_less = [](int lhs, int rhs) -> bool { return lhs < rhs; };
+  for (std::size_t length = 0; length <= 20000; length += 1 + length / 3) {
+    std::size_t length_left = generator() % (length + 1);
+    //Merged by counting.
+    auto values = get_values(length, length_left, 0, 15, false);
+    std::vector<unsigned char> bytes(values.begin(), values.end());
+    if (!VerifyMergeWithOutBufferCounting<std::vector<unsigned char>>(bytes,
+              length_left, IntegralKeyRange<unsigned char>{ 0, 15 },
+              std::less<unsigned char>(), "unsigned chars in [0, 15]"))
+      return false;
+    values = get_values(length, length_left, -500, 500, true);
+    if (!VerifyMergeWithOutBufferCounting<std::vector<int>>(values,
+              length_left, IntegralKeyRange<int>{ -500, 500 },
+              std::greater<int>(), "decreasing ints in [-500, 500]"))
+      return false;
+    //Merged by MergeWithOutBuffer1() since the key range is too large.
+    values = get_values(length, length_left, 0, 1 << 20, false);
+    if (!VerifyMergeWithOutBufferCounting<std::vector<int>>(values,
+              length_left, IntegralKeyRange<int>{ 0, 1 << 20 },
+              std::less<int>(), "ints with a large key range"))
+      return false;
+    //The hint is wrong and the left list may have more distinct values than
+    // the table can hold.
+    values = get_values(length, length_left, 0, 4 * MWOB_COUNTING_MAX_KEYS,
+                        false);
+    if (!VerifyMergeWithOutBufferCounting<std::vector<int>>(values,
+              length_left, IntegralKeyRange<int>{ 0, 15 },
+              std::less<int>(), "ints with a wrong hint"))
+      return false;
+    //Merged by MergeWithOutBuffer1() since the values cannot be merged by
+    // counting or the iterators are not random access iterators.
+    values = get_values(length, length_left, 0, 15, false);
+    if (!VerifyMergeWithOutBufferCounting<std::vector<int>>(values,
+              length_left, IntegralKeyRange<int>{ 0, 15 }, int_less,
+              "ints compared by a lambda"))
+      return false;
+    if (!VerifyMergeWithOutBufferCounting<std::list<int>>(values,
+              length_left, IntegralKeyRange<int>{ 0, 15 },
+              std::less<int>(), "a std::list of ints"))
+      return false;
+  }
+  return true;
+}
+
+/* Helper function object for VerifyMergeStringsWithOutBuffer().
+ * Returns true if lhs and rhs are equal strings or, if they are
+ *  std::string_views, if they view the same characters (so that the
+ *  stability of a merge of std::string_views can be checked).
+ */
+struct IsSameString {
+  template<typename StringType>
+  inline bool operator()(const StringType &lhs, const StringType &rhs) const {
+    return lhs == rhs;
+  }
+  inline bool operator()(const std::string_view &lhs,
+                         const std::string_view &rhs) const {
+    return lhs.data() == rhs.data() && lhs.size() == rhs.size();
+  }
+};
+
+/* Helper function for TestCorrectnessOfMergeStringsWithOutBuffer().
+ * Returns true if and only if MergeStringsWithOutBuffer() and
+ *  MergeWithOutBuffer1() and MergeWithOutBuffer2() with a SharedPrefixLess
+ *  (whose initial shared prefix length is 0 or the length of the longest
+ *  prefix that all of the strings share) all merged the lists
+ *  [0, length_left) and [length_left, N) of strings in a Container into the
+ *  list that std::stable_sort() produced.
+ */
+template<typename Container, typename StringType>
+inline bool VerifyMergeStringsWithOutBuffer(
+                                        const std::vector<StringType> &values,
+                                        std::size_t length_left,
+                                        std::size_t shared_prefix_length,
+                                        const std::string &test_name) {
+  std::vector<StringType> expected = values;
+  std::stable_sort(expected.begin(), expected.end());
+  for (int version = 0; version < 3; version++) {
+    Container container(values.begin(), values.end());
+    auto start_right = container.begin();
+    std::advance(start_right, length_left);
+    if (version == 0)
+      MergeStringsWithOutBuffer(container.begin(), start_right,
+                                container.end());
+    else if (version == 1)
+      MergeWithOutBuffer1(container.begin(), start_right, container.end(),
+                          SharedPrefixLess<StringType>());
+    else
+      MergeWithOutBuffer2(container.begin(), start_right, container.end(),
+                          SharedPrefixLess<StringType>(shared_prefix_length));
+    if (!std::equal(container.begin(), container.end(), expected.begin(),
+                    IsSameString())) {
+      std::cout << (version == 0 ? "MergeStringsWithOutBuffer()"
+                    : version == 1 ? "MergeWithOutBuffer1()"
+                                   : "MergeWithOutBuffer2()")
+                << " failed on " << test_name << " of length "
+                << values.size() << "." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeStringsWithOutBuffer(), and
+ *  MergeWithOutBuffer1() and MergeWithOutBuffer2() with a SharedPrefixLess,
+ *  merged random lists of std::strings, std::string_views, and
+ *  std::vector<char>s stored in std::vectors, std::deques, and std::lists
+ *  exactly like std::stable_sort() did. Most of the strings share a long
+ *  prefix, but some are shorter than it (i.e. they are prefixes of it) and
+ *  many are exact prefixes of each other or equal (equal std::string_views
+ *  view different characters, which checks stability).
+ */
+inline bool TestCorrectnessOfMergeStringsWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  for (std::size_t prefix_length : { 0, 7, 100, 300 }) {
+    std::string prefix(prefix_length, 'a');
+    for (char &c : prefix)
+      c = "abc/"[generator() % 4];
+    for (std::size_t length = 0; length <= 3000; length += 1 + length / 3) {
+      std::size_t length_left = generator() % (length + 1);
+      std::vector<std::string> strings(length);
+      for (std::string &string : strings) {
+        string = generator() % 5 == 0 ?
+                   prefix.substr(0, generator() % (prefix_length + 1)) : prefix;
+        string.append(generator() % 4, "ab"[generator() % 2]);
+      }
+      std::stable_sort(strings.begin(), strings.begin() + length_left);
+      std::stable_sort(strings.begin() + length_left, strings.end());
+      //The length of the longest prefix that all of the strings share.
+      std::size_t shared_prefix_length = length > 0 ? strings[0].size() : 0;
+      for (const std::string &string : strings)
+        shared_prefix_length = std::min<std::size_t>(shared_prefix_length,
+            std::mismatch(string.begin(), string.end(),
+                          strings[0].begin(), strings[0].end()).first
+            - string.begin());
+      std::vector<std::string_view> views(strings.begin(), strings.end());
+      std::vector<std::vector<char>> char_vectors;
+      for (const std::string &string : strings)
+        char_vectors.emplace_back(string.begin(), string.end());
+      if (!VerifyMergeStringsWithOutBuffer<std::vector<std::string>>(strings,
+              length_left, shared_prefix_length, "a std::vector of strings")
+          || !VerifyMergeStringsWithOutBuffer<std::deque<std::string>>(
+              strings, length_left, shared_prefix_length,
+              "a std::deque of strings")
+          || !VerifyMergeStringsWithOutBuffer<std::list<std::string>>(strings,
+              length_left, shared_prefix_length, "a std::list of strings")
+          || !VerifyMergeStringsWithOutBuffer<
+                  std::vector<std::string_view>>(views, length_left,
+              shared_prefix_length, "a std::vector of string_views")
+          || !VerifyMergeStringsWithOutBuffer<std::deque<std::string_view>>(
+              views, length_left, shared_prefix_length,
+              "a std::deque of string_views")
+          || !VerifyMergeStringsWithOutBuffer<
+                  std::vector<std::vector<char>>>(char_vectors, length_left,
+              shared_prefix_length, "a std::vector of std::vector<char>s")
+          || !VerifyMergeStringsWithOutBuffer<std::list<std::vector<char>>>(
+              char_vectors, length_left, shared_prefix_length,
+              "a std::list of std::vector<char>s"))
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeRecordsWithOutBuffer() merged random
+ *  lists of records of various sizes (both those that are merged as
+ *  FixedSizeRecords and those that are merged by byte offsets), stored at
+ *  aligned and unaligned addresses, into the stable merge of the lists.
+ * A record of record_size bytes holds a KeyAndIndex's key in its last 4
+ *  bytes and, if record_size >= 8, its index in its first 4 bytes. The other
+ *  bytes are filled with a pattern that depends on the index, so that every
+ *  byte of every record is checked.
+ */
+inline bool TestCorrectnessOfMergeRecordsWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  //The context is the offset of the key.
+  auto by_key = [](const void *lhs, const void *rhs, void *context) -> int {
+    std::size_t key_offset = *static_cast<std::size_t *>(context);
+    int lhs_key, rhs_key;
+    std::memcpy(&lhs_key, static_cast<const char *>(lhs) + key_offset, 4);
+    std::memcpy(&rhs_key, static_cast<const char *>(rhs) + key_offset, 4);
+    return (lhs_key > rhs_key) - (lhs_key < rhs_key);
+  };
+  auto to_records = [](const std::vector<KeyAndIndex> &vec,
+                       std::size_t record_size, unsigned char *records) {
+    for (std::size_t i = 0; i < vec.size(); i++) {
+      unsigned char *record = records + i * record_size;
+      for (std::size_t j = 0; j < record_size; j++)
+        record[j] = static_cast<unsigned char>(vec[i].index * 7 + j);
+      if (record_size >= 8)
+        std::memcpy(record, &vec[i].index, 4);
+      std::memcpy(record + record_size - 4, &vec[i].key, 4);
+    }
+  };
+  for (std::size_t record_size : { 4, 8, 12, 16, 24, 32, 64, 100 }) {
+    std::size_t key_offset = record_size - 4;
+    for (std::size_t length = 0; length <= 1000; length += 1 + length / 4) {
+      for (int num_keys : { 3, 1 << 20 }) {
+        std::size_t length_left = generator() % (length + 1);
+        auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                             generator);
+        auto expected = original;
+        std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                           expected.end(), KeyAndIndexLess());
+        std::vector<unsigned char> expected_records(length * record_size);
+        to_records(expected, record_size, expected_records.data());
+        for (std::size_t misalignment : { 0, 1 }) {
+          std::vector<unsigned char> buffer(length * record_size + 1);
+          unsigned char *records = buffer.data() + misalignment;
+          to_records(original, record_size, records);
+          MergeRecordsWithOutBuffer(records, length_left,
+              length - length_left, record_size, by_key, &key_offset);
+          if (!std::equal(expected_records.begin(), expected_records.end(),
+                          records)) {
+            std::cout << "MergeRecordsWithOutBuffer() failed on records of "
+                      << record_size << " bytes at misalignment "
+                      << misalignment << " with length " << length << "."
+                      << std::endl;
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeWithOutBufferBatch() merged batches of
+ *  jobs of random sizes (tiny, small, and large jobs, including empty,
+ *  already ordered, and reversed ones) that share one std::vector or one
+ *  std::list exactly like std::inplace_merge() merged each job, both on one
+ *  thread and on more threads than there are jobs.
+ */
+inline bool TestCorrectnessOfMergeWithOutBufferBatch(std::mt19937 &generator) {
+  for (std::size_t num_jobs : { 0, 1, 3, 50, 1000 }) {
+    for (std::size_t num_threads : { 1, 4, 64, 0 }) {
+      std::vector<KeyAndIndex> original, expected;
+      std::vector<std::size_t> job_starts, job_lengths_left;
+      for (std::size_t i = 0; i < num_jobs; i++) {
+        std::size_t length = generator() % 4 == 0 ? generator() % 1500
+                                                  : generator() % 30;
+        std::size_t length_left = generator() % (length + 1);
+        int num_keys = generator() % 2 == 0 ? 4 : 1 << 20;
+        auto lists = GetRandomSortedLists(length_left, length, num_keys,
+                                          generator);
+        if (i % 7 == 1) //The right list precedes the left list.
+          std::rotate(lists.begin(), lists.begin() + length_left,
+                      lists.end());
+        if (i % 7 == 2) //The lists are already in order.
+          std::sort(lists.begin(), lists.end(), KeyAndIndexLess());
+        job_starts.push_back(original.size());
+        job_lengths_left.push_back(length_left);
+        original.insert(original.end(), lists.begin(), lists.end());
+        std::inplace_merge(lists.begin(), lists.begin() + length_left,
+                           lists.end(), KeyAndIndexLess());
+        expected.insert(expected.end(), lists.begin(), lists.end());
+      }
+      job_starts.push_back(original.size());
+
+      auto vec = original;
+      typedef std::vector<KeyAndIndex>::iterator VectorIterator;
+      std::vector<MergeWithOutBufferJob<VectorIterator>> vector_jobs;
+      for (std::size_t i = 0; i < num_jobs; i++) {
+        VectorIterator start_left = vec.begin() + job_starts[i];
+        vector_jobs.push_back({ start_left, start_left + job_lengths_left[i],
+                                vec.begin() + job_starts[i + 1] });
+      }
+      MergeWithOutBufferBatch(vector_jobs.begin(), vector_jobs.end(),
+                              KeyAndIndexLess(), num_threads);
+      if (!VerifyKeysAndIndices(vec, expected,
+                      "MergeWithOutBufferBatch() on a std::vector"))
+        return false;
+
+      std::list<KeyAndIndex> list(original.begin(), original.end());
+      typedef std::list<KeyAndIndex>::iterator ListIterator;
+      std::vector<MergeWithOutBufferJob<ListIterator>> list_jobs;
+      ListIterator it = list.begin();
+      for (std::size_t i = 0; i < num_jobs; i++) {
+        ListIterator start_left = it, start_right;
+        std::advance(it, job_lengths_left[i]);
+        start_right = it;
+        std::advance(it, job_starts[i + 1] - job_starts[i]
+                         - job_lengths_left[i]);
+        list_jobs.push_back({ start_left, start_right, it });
+      }
+      MergeWithOutBufferBatch(list_jobs.begin(), list_jobs.end(),
+                              KeyAndIndexLess(), num_threads);
+      if (!VerifyKeysAndIndices(std::vector<KeyAndIndex>(list.begin(),
+                      list.end()), expected,
+                      "MergeWithOutBufferBatch() on a std::list"))
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if an IncrementalMergeWithOutBuffer whose Step()
+ *  was called with a budget of 1 or of a small prime until it returned true
+ *  merged random lists stored in a std::vector or in a std::deque exactly
+ *  like std::inplace_merge() did, using a bounded number of calls to Step().
+ */
+inline bool TestCorrectnessOfIncrementalMergeWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  typedef std::vector<KeyAndIndex>::iterator VectorIterator;
+  typedef std::deque<KeyAndIndex>::iterator DequeIterator;
+  for (std::size_t length = 0; length <= 3000; length += 1 + length / 3) {
+    for (std::size_t max_work : { 1, 2, 3, 7, 31 }) {
+      for (std::ptrdiff_t leaf_length : { 2, 32 }) {
+        std::size_t length_left = generator() % (length + 1);
+        int num_keys = generator() % 2 == 0 ? 8 : 1 << 20;
+        auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                             generator);
+        auto expected = original;
+        std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                           expected.end(), KeyAndIndexLess());
+        //Every Step() performs at least one unit of work and the whole merge
+        // performs O(length * log2(length)) units of work.
+        std::size_t max_num_steps = 64 * (length + 1) * 13;
+
+        auto vec = original;
+        IncrementalMergeWithOutBuffer<VectorIterator, KeyAndIndexLess>
+            vector_merge(vec.begin(), vec.begin() + length_left, vec.end(),
+                         KeyAndIndexLess(), leaf_length);
+        std::size_t num_steps = 1;
+        while (!vector_merge.Step(max_work) && num_steps <= max_num_steps)
+          num_steps++;
+        if (num_steps > max_num_steps || !vector_merge.IsDone()
+            || !vector_merge.Step(max_work)) {
+          std::cout << "IncrementalMergeWithOutBuffer on a std::vector failed"
+                    << " to finish with a budget of " << max_work << "."
+                    << std::endl;
+          return false;
+        }
+        if (!VerifyKeysAndIndices(vec, expected,
+                        "IncrementalMergeWithOutBuffer on a std::vector"))
+          return false;
+
+        std::deque<KeyAndIndex> deque(original.begin(), original.end());
+        IncrementalMergeWithOutBuffer<DequeIterator, KeyAndIndexLess>
+            deque_merge(deque.begin(), deque.begin() + length_left,
+                        deque.end(), KeyAndIndexLess(), leaf_length);
+        num_steps = 1;
+        while (!deque_merge.Step(max_work) && num_steps <= max_num_steps)
+          num_steps++;
+        if (num_steps > max_num_steps) {
+          std::cout << "IncrementalMergeWithOutBuffer on a std::deque failed"
+                    << " to finish with a budget of " << max_work << "."
+                    << std::endl;
+          return false;
+        }
+        if (!VerifyKeysAndIndices(std::vector<KeyAndIndex>(deque.begin(),
+                        deque.end()), expected,
+                        "IncrementalMergeWithOutBuffer on a std::deque"))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Helper function for TestCorrectnessOfMergeWithOutBufferAsync().
+ * Returns true if and only if result is a permutation of the elements whose
+ *  indices are 0, 1, ..., result.size() - 1.
+ */
+inline bool IsPermutationOfIndices(const std::vector<KeyAndIndex> &result) {
+  std::vector<bool> is_seen(result.size(), false);
+  for (const KeyAndIndex &element : result) {
+    if (element.index < 0
+        || static_cast<std::size_t>(element.index) >= result.size()
+        || is_seen[element.index])
+      return false;
+    is_seen[element.index] = true;
+  }
+  return true;
+}
+
+/* Helper function for TestCorrectnessOfMergeWithOutBufferAsync().
+ * Returns true if and only if result is a sequence of consecutive blocks
+ *  such that every element of a block is not greater than every element of
+ *  every block to its right and each block consists of at most two sorted
+ *  lists (i.e. the guarantee of a cancelled MergeWithOutBufferAsync()).
+ * It suffices to check the finest such partition, whose blocks end at every
+ *  position at which the maximum of the prefix is not greater than the
+ *  minimum of the suffix.
+ */
+inline bool IsSequenceOfMergeableBlocks(
+                                    const std::vector<KeyAndIndex> &result) {
+  std::size_t length = result.size();
+  //suffix_min[i] is the least key of result[i, length).
+  std::vector<int> suffix_min(length + 1, 0);
+  for (std::size_t i = length; i-- > 0; ) {
+    suffix_min[i] = i + 1 == length ? result[i].key
+                              : std::min(result[i].key, suffix_min[i + 1]);
+  }
+  int prefix_max = 0;
+  int num_descents_in_block = 0;
+  for (std::size_t i = 0; i < length; i++) {
+    //A block never ends between two elements that are out of order.
+    if (i > 0 && result[i].key < result[i - 1].key)
+      num_descents_in_block++;
+    if (num_descents_in_block > 1)
+      return false;
+    prefix_max = i == 0 ? result[i].key : std::max(prefix_max, result[i].key);
+    if (prefix_max <= suffix_min[i + 1])
+      num_descents_in_block = 0; //A block ends at result[i].
+  }
+  return true;
+}
+
+/* Returns true if and only if MergeWithOutBufferAsync()
+ *  (1) merged random lists exactly like std::inplace_merge() did and
+ *      returned true when it was not cancelled (on a NewThreadExecutor and on
+ *      an executor that runs the task later on this thread), and
+ *  (2) returned false and left a permutation of the input when it was
+ *      cancelled before the task started or in the middle of the merge (by
+ *      the comparison function, after a random number of comparisons).
+ */
+inline bool TestCorrectnessOfMergeWithOutBufferAsync(std::mt19937 &generator) {
+  typedef std::vector<KeyAndIndex>::iterator Iterator;
+  //Requests cancellation once it has performed max_num_comparisons.
+  struct CancellingLess {
+    inline bool operator()(const KeyAndIndex &lhs,
+                           const KeyAndIndex &rhs) const {
+      if (++*num_comparisons == max_num_comparisons)
+        token.RequestCancellation();
+      return lhs.key < rhs.key;
+    }
+    std::size_t *num_comparisons;
+    std::size_t max_num_comparisons;
+    MergeCancellationToken token;
+  };
+  std::vector<std::function<void()>> tasks;
+  auto deferred_executor = [&tasks](std::function<void()> task) {
+    tasks.push_back(std::move(task));
+  };
+  const std::size_t kWorkQuantum = 16;
+  for (std::size_t length = 0; length <= 5000; length += 1 + length / 2) {
+    for (int num_keys : { 8, 1 << 20 }) {
+      std::size_t length_left = generator() % (length + 1);
+      auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                           generator);
+      auto expected = original;
+      std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                         expected.end(), KeyAndIndexLess());
+
+      auto vec = original;
+      std::future<bool> result = MergeWithOutBufferAsync(NewThreadExecutor(),
+          vec.begin(), vec.begin() + length_left, vec.end(),
+          KeyAndIndexLess(), MergeCancellationToken(), kWorkQuantum);
+      if (!result.get()) {
+        std::cout << "MergeWithOutBufferAsync() failed: it returned false "
+                  << "although it was not cancelled." << std::endl;
+        return false;
+      }
+      if (!VerifyKeysAndIndices(vec, expected, "MergeWithOutBufferAsync()"))
+        return false;
+
+      //Cancel before the task starts, in which case exactly one slice of
+      // work is performed, then in the middle of the merge.
+      for (int is_cancelled_before_start = 1; is_cancelled_before_start >= 0;
+           is_cancelled_before_start--) {
+        std::size_t num_comparisons = 0;
+        MergeCancellationToken token;
+        CancellingLess comp{ &num_comparisons,
+                             1 + generator() % (2 * length + 1), token };
+        if (is_cancelled_before_start)
+          token.RequestCancellation();
+        vec = original;
+        result = MergeWithOutBufferAsync(deferred_executor, vec.begin(),
+                     vec.begin() + length_left, vec.end(), comp, token,
+                     kWorkQuantum);
+        for (auto &task : tasks)
+          task();
+        tasks.clear();
+        bool was_completed = result.get();
+        if (!IsPermutationOfIndices(vec) || !IsSequenceOfMergeableBlocks(vec)
+            || (was_completed && !VerifyKeysAndIndices(vec, expected,
+                                     "MergeWithOutBufferAsync()"))) {
+          std::cout << "MergeWithOutBufferAsync() failed: after it was "
+                    << "cancelled the range is not a permutation of the input"
+                    << " that consists of mergeable blocks." << std::endl;
+          return false;
+        }
+        if (is_cancelled_before_start) {
+          auto one_slice = original;
+          IncrementalMergeWithOutBuffer<Iterator, KeyAndIndexLess> merge(
+              one_slice.begin(), one_slice.begin() + length_left,
+              one_slice.end(), KeyAndIndexLess());
+          merge.Step(kWorkQuantum);
+          merge.FinishPartialSwap();
+          if (was_completed != merge.IsDone()) {
+            std::cout << "MergeWithOutBufferAsync() failed: it did not stop "
+                      << "after one slice of work although it was cancelled "
+                      << "before it started." << std::endl;
+            return false;
+          }
+          if (!VerifyKeysAndIndices(vec, one_slice,
+                      "MergeWithOutBufferAsync() cancelled before it started"))
+            return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if an LsmSortedArray that ingested random batches
+ *  (under both compaction policies and for several size ratios)
+ *  (1) kept its elements as a sequence of sorted runs that cover the array
+ *      (and, for CompactionPolicy::Leveled, whose lengths decrease
+ *      geometrically) and answered Count() and Contains() correctly for
+ *      present and absent keys before CompactAll() was called, and
+ *  (2) held, after CompactAll(), the stable sort of the ingested elements
+ *      in the order in which they were ingested.
+ */
+inline bool TestCorrectnessOfLsmSortedArray(std::mt19937 &generator) {
+  typedef LsmSortedArray<KeyAndIndex, KeyAndIndexLess> Lsm;
+  const int kNumKeys = 40;
+  for (Lsm::CompactionPolicy policy : { Lsm::CompactionPolicy::Tiered,
+                                        Lsm::CompactionPolicy::Leveled }) {
+    for (std::size_t size_ratio : { 2, 3, 4 }) {
+      Lsm lsm(policy, size_ratio);
+      std::vector<KeyAndIndex> ingested;
+      std::vector<std::size_t> key_counts(kNumKeys, 0);
+      for (int batch = 0; batch < 200; batch++) {
+        std::size_t batch_length = batch % 10 == 0 ? 0 : generator() % 100;
+        auto elements = GetRandomKeysAndIndices(batch_length, kNumKeys,
+                                                generator);
+        for (KeyAndIndex &element : elements) {
+          element.index = static_cast<int>(ingested.size());
+          ingested.push_back(element);
+          key_counts[element.key]++;
+        }
+        lsm.Ingest(elements.begin(), elements.end());
+
+        bool is_correct = lsm.Size() == ingested.size();
+        std::size_t run_start = 0;
+        const auto &runs = lsm.Runs();
+        for (std::size_t i = 0; i < runs.size(); i++) {
+          is_correct = is_correct && runs[i].start == run_start
+                       && runs[i].length > 0
+                       && std::is_sorted(lsm.begin() + runs[i].start,
+                              lsm.begin() + runs[i].start + runs[i].length,
+                              KeyAndIndexLess());
+          if (policy == Lsm::CompactionPolicy::Leveled && i + 1 < runs.size())
+            is_correct = is_correct
+                         && runs[i].length > size_ratio * runs[i + 1].length;
+          run_start += runs[i].length;
+        }
+        is_correct = is_correct && run_start == lsm.Size();
+        for (int key = -1; key <= kNumKeys; key++) {
+          KeyAndIndex value{ key, 0 };
+          std::size_t expected_count = key >= 0 && key < kNumKeys
+                                       ? key_counts[key] : 0;
+          is_correct = is_correct && lsm.Count(value) == expected_count
+                       && lsm.Contains(value) == (expected_count > 0);
+        }
+        if (!is_correct) {
+          std::cout << "LsmSortedArray failed: after " << batch + 1
+                    << " batches its runs or the results of Count() or "
+                    << "Contains() are wrong." << std::endl;
+          return false;
+        }
+      }
+      lsm.CompactAll();
+      auto expected = ingested;
+      std::stable_sort(expected.begin(), expected.end(), KeyAndIndexLess());
+      if (!lsm.IsFullyCompacted()) {
+        std::cout << "LsmSortedArray failed: CompactAll() left "
+                  << lsm.NumberOfRuns() << " runs." << std::endl;
+        return false;
+      }
+      if (!VerifyKeysAndIndices(std::vector<KeyAndIndex>(lsm.begin(),
+                      lsm.end()), expected, "LsmSortedArray::CompactAll()"))
+        return false;
+    }
+  }
+  return true;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/* Helper function for the TestCorrectnessOf...() functions that use files.
+ * Creates a new temporary file (in $TMPDIR or /tmp) that holds the bytes of
+ *  vec followed by num_extra_bytes zero bytes, and returns its path, or
+ *  returns the empty string if the file could not be written. The caller
+ *  removes the file.
+ */
+inline std::string WriteToTemporaryFile(const std::vector<KeyAndIndex> &vec,
+                                        std::size_t num_extra_bytes = 0) {
+  const char *directory = std::getenv("TMPDIR");
+  std::string path = std::string(directory != nullptr ? directory : "/tmp")
+                     + "/merge_test_XXXXXX";
+  std::vector<char> path_template(path.begin(), path.end());
+  path_template.push_back('\0');
+  int fd = mkstemp(path_template.data());
+  if (fd < 0)
+    return std::string();
+  path = path_template.data();
+  std::FILE *file = fdopen(fd, "wb");
+  if (file == nullptr) {
+    close(fd);
+    std::remove(path.c_str());
+    return std::string();
+  }
+  std::vector<char> extra_bytes(num_extra_bytes, 0);
+  bool is_written = std::fwrite(vec.data(), sizeof(KeyAndIndex), vec.size(),
+                                file) == vec.size()
+                    && std::fwrite(extra_bytes.data(), 1, num_extra_bytes,
+                                   file) == num_extra_bytes;
+  if (std::fclose(file) != 0 || !is_written) {
+    std::remove(path.c_str());
+    return std::string();
+  }
+  return path;
+}
+
+/* Helper function for the TestCorrectnessOf...() functions that use files.
+ * Returns the records of the file at path (which must hold a whole number of
+ *  records).
+ */
+inline std::vector<KeyAndIndex> ReadFromFile(const std::string &path) {
+  std::vector<KeyAndIndex> vec;
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    return vec;
+  KeyAndIndex record;
+  while (std::fread(&record, sizeof(KeyAndIndex), 1, file) == 1)
+    vec.push_back(record);
+  std::fclose(file);
+  return vec;
+}
+
+/* Returns true if and only if MergeWithOutBufferMappedFile() merged files
+ *  that hold two random sorted runs exactly like std::inplace_merge() did
+ *  and returned -EINVAL for a file whose size is not a multiple of the size
+ *  of a record and for a left run that is longer than the file.
+ */
+inline bool TestCorrectnessOfMergeWithOutBufferMappedFile(
+                                                    std::mt19937 &generator) {
+  KeyAndIndexLess comp;
+  for (std::size_t length = 0; length <= 100000; length += 1 + length) {
+    for (int num_keys : { 16, 1 << 20 }) {
+      for (int left_kind = 0; left_kind < 3; left_kind++) {
+        std::size_t length_left = left_kind == 0 ? 0 : left_kind == 1 ? length
+                                  : generator() % (length + 1);
+        auto original = GetRandomSortedLists(length_left, length, num_keys,
+                                             generator);
+        auto expected = original;
+        std::inplace_merge(expected.begin(), expected.begin() + length_left,
+                           expected.end(), comp);
+        std::string path = WriteToTemporaryFile(original);
+        if (path.empty()) {
+          std::cout << "Could not write a temporary file." << std::endl;
+          return false;
+        }
+        int result = MergeWithOutBufferMappedFile<KeyAndIndex>(path.c_str(),
+                                                       length_left, comp);
+        auto merged = ReadFromFile(path);
+        std::remove(path.c_str());
+        if (result != 0) {
+          std::cout << "MergeWithOutBufferMappedFile() failed: it returned "
+                    << result << "." << std::endl;
+          return false;
+        }
+        if (!VerifyKeysAndIndices(merged, expected,
+                                  "MergeWithOutBufferMappedFile()"))
+          return false;
+      }
+    }
+  }
+  //Invalid sizes.
+  auto original = GetRandomSortedLists(10, 20, 16, generator);
+  for (int is_size_invalid = 0; is_size_invalid < 2; is_size_invalid++) {
+    std::string path = WriteToTemporaryFile(original, is_size_invalid ? 3 : 0);
+    if (path.empty()) {
+      std::cout << "Could not write a temporary file." << std::endl;
+      return false;
+    }
+    std::size_t length_left = is_size_invalid ? 10 : original.size() + 1;
+    int result = MergeWithOutBufferMappedFile<KeyAndIndex>(path.c_str(),
+                                                           length_left, comp);
+    std::remove(path.c_str());
+    if (result != -EINVAL) {
+      std::cout << "MergeWithOutBufferMappedFile() failed: it returned "
+                << result << " instead of -EINVAL." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns true if and only if ExternalSortWithOutBuffer() sorted files of
+ *  random records with many duplicate keys (whose indices are their
+ *  payloads) exactly like std::stable_sort() did when given memory budgets
+ *  of a few records and fan_ins of 2 and 3 (so that many merge passes are
+ *  needed), and returned -EINVAL for an input whose size is not a multiple of
+ *  the size of a record and for a memory budget of less than 2 records.
+ */
+inline bool TestCorrectnessOfExternalSortWithOutBuffer(
+                                                    std::mt19937 &generator) {
+  KeyAndIndexLess comp;
+  std::string output_path = WriteToTemporaryFile(std::vector<KeyAndIndex>());
+  if (output_path.empty()) {
+    std::cout << "Could not write a temporary file." << std::endl;
+    return false;
+  }
+  //Sorts a file that holds original and returns true if and only if the
+  // returned value is expected_result and, if it is 0, the output is the
+  // stable sort of original.
+  auto sort_file = [&](const std::vector<KeyAndIndex> &original,
+                       std::size_t num_extra_bytes,
+                       std::size_t memory_budget_bytes, std::size_t fan_in,
+                       int expected_result) -> bool {
+    std::string input_path = WriteToTemporaryFile(original, num_extra_bytes);
+    if (input_path.empty()) {
+      std::cout << "Could not write a temporary file." << std::endl;
+      return false;
+    }
+    int result = ExternalSortWithOutBuffer<KeyAndIndex>(input_path.c_str(),
+                     output_path.c_str(), memory_budget_bytes, comp, fan_in);
+    std::remove(input_path.c_str());
+    if (result != expected_result) {
+      std::cout << "ExternalSortWithOutBuffer() failed: it returned " << result
+                << " instead of " << expected_result << "." << std::endl;
+      return false;
+    }
+    if (result != 0)
+      return true;
+    auto expected = original;
+    std::stable_sort(expected.begin(), expected.end(), comp);
+    return VerifyKeysAndIndices(ReadFromFile(output_path), expected,
+                                "ExternalSortWithOutBuffer()");
+  };
+  bool is_correct = true;
+  for (std::size_t length = 0; length <= 20000 && is_correct;
+       length += 1 + length) {
+    for (int num_keys : { 5, 1 << 20 }) {
+      for (std::size_t memory_budget_records : { 2, 7, 64 }) {
+        for (std::size_t fan_in : { 2, 3, 0 }) {
+          //The budget need not be a multiple of the size of a record.
+          is_correct = is_correct && sort_file(
+                           GetRandomKeysAndIndices(length, num_keys, generator),
+                           0, memory_budget_records * sizeof(KeyAndIndex) + 3,
+                           fan_in, 0);
+        }
+      }
+    }
+  }
+  //Invalid sizes.
+  auto original = GetRandomKeysAndIndices(20, 16, generator);
+  is_correct = is_correct
+            && sort_file(original, 3, 1000, 2, -EINVAL)
+            && sort_file(original, 0, 2 * sizeof(KeyAndIndex) - 1, 2, -EINVAL);
+  std::remove(output_path.c_str());
+  return is_correct;
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) */
+
+/* Returns true if and only if all of the above tests succeeded.
+ */
+inline bool TestCorrectnessOfAdditionalInterfaces() {
+  std::mt19937 generator(2026);
+  bool result = TestCorrectnessOfMergesOfPointers(generator)
+             && TestCorrectnessOfUnbalancedMerges(generator)
+             && TestCorrectnessOfMergeNetworks(generator)
+             && TestCorrectnessOfCoRank(generator)
+             && TestCorrectnessOfMergedView(generator)
+             && TestCorrectnessOfPartialMergeWithOutBuffer(generator)
+             && TestCorrectnessOfBlockExchanges(generator)
+             && TestCorrectnessOfStableSortWithOutBuffer(generator)
+             && TestCorrectnessOfFlatSortedVector(generator)
+             && TestCorrectnessOfMergeWatchdog(generator)
+             && TestCorrectnessOfSetOperationsWithOutBuffer(generator)
+             && TestCorrectnessOfMergeReduceWithOutBuffer(generator)
+             && TestCorrectnessOfStablePartitionWithOutBuffer(generator)
+             && TestCorrectnessOfMergeWithOutBufferCounting(generator)
+             && TestCorrectnessOfMergeStringsWithOutBuffer(generator)
+             && TestCorrectnessOfMergeRecordsWithOutBuffer(generator)
+             && TestCorrectnessOfMergeWithOutBufferBatch(generator)
+             && TestCorrectnessOfIncrementalMergeWithOutBuffer(generator)
+             && TestCorrectnessOfMergeWithOutBufferAsync(generator)
+             && TestCorrectnessOfLsmSortedArray(generator);
+#if defined(__unix__) || defined(__APPLE__)
+  result = result && TestCorrectnessOfMergeWithOutBufferMappedFile(generator)
+                  && TestCorrectnessOfExternalSortWithOutBuffer(generator);
+#endif
+  if (result)
+    std::cout << "The additional interfaces passed all tests." << std::endl;
+  return result;
+}
+
+#endif /* SRC_MERGE_TEST_ADDITIONAL_INTERFACES_H_ */
@@ -0,0 +1,139 @@
+/*
+ * merge_test_constexpr.h
+ *
+ *  When the merges are constexpr (i.e. when MWOB_CONSTEXPR20 is constexpr,
+ *   which requires C++20, e.g. g++ -std=c++20 main.cpp), this header file
+ *   checks with static_asserts that MergeWithOutBuffer1(),
+ *   MergeWithOutBuffer2(), and RotateWithOutBuffer() give the right results
+ *   when they are evaluated at compile time on std::arrays. The cases cover
+ *   the paths that must avoid memcpy() and function pointers in constant
+ *   expressions: the tiled block exchanges (long arrays of ints), the merge
+ *   networks (short lists of ints compared by std::less or std::greater),
+ *   and the unbalanced merge, as well as the stability of merges of elements
+ *   with equivalent keys.
+ *  Otherwise this header file does nothing.
+ */
+
+#ifndef SRC_MERGE_TEST_CONSTEXPR_H_
+#define SRC_MERGE_TEST_CONSTEXPR_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+
+#include "../merge_without_buffer1.h"
+#include "../merge_without_buffer2.h"
+#include "../merge_without_buffer_rotate.h"
+
+#if defined(__cpp_lib_constexpr_algorithms) && \
+    defined(__cpp_lib_is_constant_evaluated)
+
+namespace merge_test_constexpr_namespace {
+
+struct ConstexprKeyAndIndex {
+  int key;
+  int index;
+};
+
+struct ConstexprKeyAndIndexLess {
+  constexpr bool operator()(const ConstexprKeyAndIndex &lhs,
+                            const ConstexprKeyAndIndex &rhs) const {
+    return lhs.key < rhs.key;
+  }
+};
+
+/* Returns true if and only if MergeWithOutBuffer<Version>() merged the lists
+ *  [0, LengthLeft) and [LengthLeft, Length) of ints, which are
+ *  (Multiplier * i) % Modulus sorted according to comp, into a sorted list
+ *  that has the same number of occurrences of each value.
+ */
+template<int Version, std::size_t Length, std::size_t LengthLeft,
+         int Multiplier, int Modulus, typename Compare>
+constexpr bool IsMergeOfIntsCorrect(Compare comp) {
+  std::array<int, Length> values{};
+  for (std::size_t i = 0; i < Length; i++)
+    values[i] = static_cast<int>((Multiplier * i) % Modulus);
+  std::array<int, Length> expected = values;
+  std::sort(values.begin(), values.begin() + LengthLeft, comp);
+  std::sort(values.begin() + LengthLeft, values.end(), comp);
+  std::sort(expected.begin(), expected.end(), comp);
+  if constexpr (Version == 1)
+    MergeWithOutBuffer1(values.begin(), values.begin() + LengthLeft,
+                        values.end(), comp);
+  else
+    MergeWithOutBuffer2(values.begin(), values.begin() + LengthLeft,
+                        values.end(), comp);
+  return values == expected;
+}
+
+/* Returns true if and only if MergeWithOutBuffer<Version>() stably merged
+ *  the lists [0, LengthLeft) and [LengthLeft, Length), in which runs of
+ *  RunLength (resp. 3) consecutive elements of the left (resp. right) list
+ *  have equivalent keys.
+ */
+template<int Version, std::size_t Length, std::size_t LengthLeft,
+         int RunLength>
+constexpr bool IsMergeStable() {
+  std::array<ConstexprKeyAndIndex, Length> values{};
+  for (std::size_t i = 0; i < Length; i++) {
+    int key = i < LengthLeft ? static_cast<int>(i) / RunLength
+                             : static_cast<int>(i - LengthLeft) / 3;
+    values[i] = ConstexprKeyAndIndex{ key, static_cast<int>(i) };
+  }
+  if constexpr (Version == 1)
+    MergeWithOutBuffer1(values.begin(), values.begin() + LengthLeft,
+                        values.end(), ConstexprKeyAndIndexLess());
+  else
+    MergeWithOutBuffer2(values.begin(), values.begin() + LengthLeft,
+                        values.end(), ConstexprKeyAndIndexLess());
+  for (std::size_t i = 1; i < Length; i++) {
+    if (values[i].key < values[i - 1].key ||
+        (values[i].key == values[i - 1].key &&
+         values[i].index < values[i - 1].index))
+      return false;
+  }
+  return true;
+}
+
+/* Returns true if and only if RotateWithOutBuffer() rotated an array of
+ *  Length ints by Shift like std::rotate() did.
+ */
+template<std::size_t Length, std::size_t Shift>
+constexpr bool IsRotationCorrect() {
+  std::array<int, Length> values{}, expected{};
+  for (std::size_t i = 0; i < Length; i++)
+    values[i] = expected[i] = static_cast<int>(i);
+  auto new_middle = RotateWithOutBuffer(values.begin(),
+                                        values.begin() + Shift, values.end());
+  std::rotate(expected.begin(), expected.begin() + Shift, expected.end());
+  return values == expected && new_middle == values.begin() + (Length - Shift);
+}
+
+//Long lists (tiled block exchanges) and short lists (merge networks).
+static_assert(IsMergeOfIntsCorrect<1, 600, 250, 37, 1000>(std::less<int>()));
+static_assert(IsMergeOfIntsCorrect<2, 600, 250, 37, 1000>(std::less<int>()));
+static_assert(IsMergeOfIntsCorrect<1, 600, 400, 7, 20>(std::greater<int>()));
+static_assert(IsMergeOfIntsCorrect<2, 600, 400, 7, 20>(std::greater<int>()));
+static_assert(IsMergeOfIntsCorrect<1, 11, 5, 3, 7>(std::less<int>()));
+static_assert(IsMergeOfIntsCorrect<2, 11, 6, 3, 7>(std::greater<int>()));
+//Very unbalanced lists.
+static_assert(IsMergeOfIntsCorrect<1, 400, 3, 13, 100>(std::less<int>()));
+static_assert(IsMergeOfIntsCorrect<2, 400, 397, 13, 100>(std::less<int>()));
+//Stability.
+static_assert(IsMergeStable<1, 300, 120, 4>());
+static_assert(IsMergeStable<2, 300, 120, 4>());
+static_assert(IsMergeStable<1, 200, 5, 1>());
+static_assert(IsMergeStable<2, 200, 195, 2>());
+//Rotations.
+static_assert(IsRotationCorrect<1000, 0>());
+static_assert(IsRotationCorrect<1000, 1>());
+static_assert(IsRotationCorrect<1000, 999>());
+static_assert(IsRotationCorrect<1000, 500>());
+static_assert(IsRotationCorrect<1000, 333>());
+
+} //END namespace: merge_test_constexpr_namespace
+
+#endif /* defined(__cpp_lib_constexpr_algorithms) && ... */
+
+#endif /* SRC_MERGE_TEST_CONSTEXPR_H_ */
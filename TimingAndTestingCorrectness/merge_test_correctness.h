@@ -162,7 +162,8 @@ bool MergeTwoSortedSubvectorsTestCorrectness(int vec_size,
   }
 
   typedef typename std::vector<ValueType>::iterator iterator_type;
-  MergeWithOutBuffer<iterator_type, typename iterator_type::difference_type>(
+  MergeWithOutBuffer<iterator_type,
+           typename std::iterator_traits<iterator_type>::difference_type>(
                      vec.begin() + start_left,
                      vec.begin() + start_right, vec.begin() + (end_right + 1),
                      comp);
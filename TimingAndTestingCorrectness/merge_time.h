@@ -191,7 +191,7 @@ struct StdMerge {
                          Distance length_left,
                          Distance length_right,
                          Compare comp) {
-    typedef typename Iterator::value_type ValueType;
+    typedef typename std::iterator_traits<Iterator>::value_type ValueType;
     std::vector<ValueType> temp_vec(length_left + length_right);
     std::merge(start_left, start_right, start_right, one_past_end_right,
                temp_vec.begin(), comp);
@@ -255,7 +255,7 @@ std::chrono::nanoseconds TimeMergeOnGivenVec(Iterator iter_left_start,
                                      TestingOptions &to,
                                      Compare comp,
                                      std::string function_name_string) {
-  typedef typename Iterator::difference_type Distance;
+  typedef typename std::iterator_traits<Iterator>::difference_type Distance;
   typedef std::size_t SizeType;
   typedef MergeFunction<Iterator, Compare, Distance> MergeFunctionClass;
   std::chrono::nanoseconds total{0};
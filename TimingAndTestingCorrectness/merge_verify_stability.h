@@ -124,7 +124,7 @@ bool VerifyMergeStabilityOnGivenVec(SizeType vec_size,
   typedef ObjectAndIndex<ValueType, Compare> ObAndInType;
   typedef ContainerType<ObAndInType, std::allocator<ObAndInType>> Container;
   typedef typename Container::iterator Iterator;
-  typedef typename Iterator::difference_type Distance;
+  typedef typename std::iterator_traits<Iterator>::difference_type Distance;
   auto object_and_index_comp = [comp](const ObAndInType &lhs,
                                       const ObAndInType &rhs) -> bool {
     return comp(lhs.ob, rhs.ob);
@@ -178,7 +178,7 @@ bool VerifyMergeStability(int vec_size,
   typedef ObjectAndIndex<ValueType, Compare> ObAndInType;
   typedef ContainerType<ObAndInType, std::allocator<ObAndInType>> Container;
   typedef typename Container::iterator Iterator;
-  typedef typename Iterator::difference_type Distance;
+  typedef typename std::iterator_traits<Iterator>::difference_type Distance;
   Distance length_left  = start_right - start_left;
   Distance length_right = one_past_end_right - start_right;
   if (vec_size <= 1) {
@@ -0,0 +1,213 @@
+/*
+ * flat_sorted_vector.h
+ *
+ *  flat_sorted_vector<T, Compare> is a sorted multiset that stores its
+ *   elements contiguously in a single std::vector<T> (so, unlike std::set,
+ *   there is no per element overhead).
+ *  The vector consists of a sorted prefix followed by a (small) unsorted
+ *   tail into which new elements are inserted. Once the tail reaches
+ *   max_tail_length elements, or when an operation needs the whole vector to
+ *   be sorted (e.g. begin() or lower_bound()), the tail is sorted with
+ *   StableSortWithOutBuffer() and merged into the sorted prefix in place by
+ *   MergeWithOutBuffer2(); neither allocates any memory.
+ *  count() and contains() do not require the tail to be sorted: they binary
+ *   search the sorted prefix and then linearly scan the tail. find(), like
+ *   every other member function that returns an iterator, first flushes the
+ *   tail so that the iterators it returns always point into the sorted
+ *   vector.
+ *  Equivalent elements are kept in insertion order (i.e. the container is
+ *   stable).
+ *
+ *  The member functions are named after those of the standard library's
+ *   containers so that flat_sorted_vector can be used in place of them.
+ *  Iterators are invalidated by any insertion, erasure, or flush().
+ *
+ *  Unlike the standard library's containers, the const member functions
+ *   that may flush the tail (begin(), end(), operator[](), find(),
+ *   lower_bound(), upper_bound(), and equal_range()) modify the underlying
+ *   vector, so concurrent calls to const member functions are NOT
+ *   thread-safe. Once flush() has returned, and until the next insertion,
+ *   they only read the vector and may then be called concurrently.
+ */
+
+#ifndef SRC_FLAT_SORTED_VECTOR_H_
+#define SRC_FLAT_SORTED_VECTOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "merge_without_buffer2.h"
+#include "merge_without_buffer_sort.h"
+
+#ifndef MWOB_FLAT_SORTED_VECTOR_DEFAULT_TAIL_LENGTH
+#define MWOB_FLAT_SORTED_VECTOR_DEFAULT_TAIL_LENGTH 256
+#endif
+
+template<typename T, typename Compare = std::less<T>,
+         typename Allocator = std::allocator<T>>
+class flat_sorted_vector {
+public:
+  typedef std::vector<T, Allocator> container_type;
+  typedef T value_type;
+  typedef Compare value_compare;
+  typedef typename container_type::size_type size_type;
+  typedef typename container_type::difference_type difference_type;
+  typedef typename container_type::const_reference const_reference;
+  typedef typename container_type::const_iterator const_iterator;
+  typedef const_iterator iterator;
+
+  explicit flat_sorted_vector(Compare comp = Compare(),
+             size_type max_tail_length =
+                                 MWOB_FLAT_SORTED_VECTOR_DEFAULT_TAIL_LENGTH)
+      : comp_(comp),
+        max_tail_length_(max_tail_length > 0 ? max_tail_length : 1) {
+  }
+
+  flat_sorted_vector(std::initializer_list<T> values, Compare comp = Compare())
+      : flat_sorted_vector(comp) {
+    insert(values.begin(), values.end());
+  }
+
+  void insert(const T &value) {
+    data_.push_back(value);
+    FlushIfTailIsFull();
+    return ;
+  }
+
+  void insert(T &&value) {
+    data_.push_back(std::move(value));
+    FlushIfTailIsFull();
+    return ;
+  }
+
+  template<typename... Args>
+  void emplace(Args&&... args) {
+    data_.emplace_back(std::forward<Args>(args)...);
+    FlushIfTailIsFull();
+    return ;
+  }
+
+  //Inserts [start, one_past_end). The inserted elements are merged into the
+  // sorted prefix by a single merge, regardless of how many there are.
+  template<typename InputIterator>
+  void insert(InputIterator start, InputIterator one_past_end) {
+    data_.insert(data_.end(), start, one_past_end);
+    if (data_.size() - sorted_size_ >= max_tail_length_)
+      flush();
+    return ;
+  }
+
+  //Sorts the tail and merges it into the sorted prefix.
+  void flush() const {
+    if (sorted_size_ == data_.size())
+      return ;
+    auto start_tail = data_.begin() + sorted_size_;
+    StableSortWithOutBuffer(start_tail, data_.end(), comp_);
+    MergeWithOutBuffer2(data_.begin(), start_tail, data_.end(), comp_);
+    sorted_size_ = data_.size();
+    return ;
+  }
+
+  //Returns an iterator to the first element that is equivalent to value,
+  // or end() if there is no such element.
+  const_iterator find(const T &value) const {
+    flush();
+    auto it = std::lower_bound(data_.cbegin(), data_.cend(), value, comp_);
+    if (it != data_.cend() && !comp_(value, *it))
+      return it;
+    return data_.cend();
+  }
+
+  size_type count(const T &value) const {
+    auto one_past_sorted = data_.cbegin() + sorted_size_;
+    auto range = std::equal_range(data_.cbegin(), one_past_sorted, value,
+                                  comp_);
+    size_type num = static_cast<size_type>(range.second - range.first);
+    for (auto it = one_past_sorted; it != data_.cend(); ++it) {
+      if (!comp_(*it, value) && !comp_(value, *it))
+        num++;
+    }
+    return num;
+  }
+
+  bool contains(const T &value) const {
+    auto one_past_sorted = data_.cbegin() + sorted_size_;
+    if (std::binary_search(data_.cbegin(), one_past_sorted, value, comp_))
+      return true;
+    for (auto it = one_past_sorted; it != data_.cend(); ++it) {
+      if (!comp_(*it, value) && !comp_(value, *it))
+        return true;
+    }
+    return false;
+  }
+
+  const_iterator lower_bound(const T &value) const {
+    flush();
+    return std::lower_bound(data_.cbegin(), data_.cend(), value, comp_);
+  }
+
+  const_iterator upper_bound(const T &value) const {
+    flush();
+    return std::upper_bound(data_.cbegin(), data_.cend(), value, comp_);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const T &value) const {
+    flush();
+    return std::equal_range(data_.cbegin(), data_.cend(), value, comp_);
+  }
+
+  //Erases all elements equivalent to value and returns how many there were.
+  size_type erase(const T &value) {
+    auto range = equal_range(value);
+    size_type num = static_cast<size_type>(range.second - range.first);
+    data_.erase(range.first, range.second);
+    sorted_size_ = data_.size();
+    return num;
+  }
+
+  const_iterator erase(const_iterator position) {
+    flush();
+    auto it = data_.erase(position);
+    sorted_size_ = data_.size();
+    return it;
+  }
+
+  const_iterator begin()  const { flush(); return data_.cbegin(); }
+  const_iterator end()    const { flush(); return data_.cend(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend()   const { return end(); }
+  const_reference operator[](size_type i) const { flush(); return data_[i]; }
+
+  size_type size()  const { return data_.size(); }
+  bool      empty() const { return data_.empty(); }
+  void reserve(size_type capacity) { data_.reserve(capacity); return ; }
+  void shrink_to_fit() { data_.shrink_to_fit(); return ; }
+  void clear() { data_.clear(); sorted_size_ = 0; return ; }
+
+  size_type sorted_size() const { return sorted_size_; }
+  size_type max_tail_length() const { return max_tail_length_; }
+  value_compare value_comp() const { return comp_; }
+
+private:
+  void FlushIfTailIsFull() {
+    if (data_.size() - sorted_size_ >= max_tail_length_)
+      flush();
+    return ;
+  }
+
+  //These are mutable because reading the container (e.g. begin()) may need
+  // to first merge the tail into the sorted prefix, which does not change
+  // the (logical) contents of the container.
+  mutable container_type data_;
+  mutable size_type sorted_size_ = 0;
+  Compare comp_;
+  size_type max_tail_length_;
+};
+
+#endif /* SRC_FLAT_SORTED_VECTOR_H_ */
@@ -45,6 +45,8 @@
 #include "merge_without_buffer2.h"
 
 #include "TimingAndTestingCorrectness/main_timing_verifying_with_settings.h"
+#include "TimingAndTestingCorrectness/merge_test_additional_interfaces.h"
+#include "TimingAndTestingCorrectness/merge_test_constexpr.h"
 
 /*
 To customize the testing and timing of these new algorithms, see the file:
@@ -65,6 +67,10 @@ int main() {
 
   to.should_print_to_file = false;
 
+  //Test the additional interfaces (see README.md) before timing the merges.
+  if (!TestCorrectnessOfAdditionalInterfaces())
+    return -1;
+
   std::vector<Timings> timings_vector;
   {//Test and time the algorithms when containers are std::vector
   to.SetContainerType(TestingOptions::ContainerTypeEnum::vector_type);
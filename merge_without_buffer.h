@@ -154,10 +154,12 @@
 #include "merge_without_buffer_common.h"
 #include "merge_without_buffer.h"
 #include "merge_without_buffer2.h"
+#include "merge_without_buffer_counting.h"
 
 //Dispatch function
 template<typename Iterator, typename Compare,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
 inline void MergeWithOutBuffer(Iterator start_left,
                                Iterator start_right,
                                Iterator one_past_end_right,
@@ -171,7 +173,8 @@ inline void MergeWithOutBuffer(Iterator start_left,
 }
 
 template<typename Iterator, typename Compare,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
 inline void MergeWithOutBuffer(Iterator start_left,
                                 Iterator start_right,
                                 Iterator one_past_end_right,
@@ -184,6 +187,19 @@ inline void MergeWithOutBuffer(Iterator start_left,
   return ;
 }
 
+//Merges by counting (see MergeWithOutBufferCounting()) if the caller's hint
+// that every value lies in key_range makes this possible.
+template<typename Iterator, typename Compare, typename KeyType>
+inline void MergeWithOutBuffer(Iterator start_left,
+                               Iterator start_right,
+                               Iterator one_past_end_right,
+                               Compare comp,
+                               IntegralKeyRange<KeyType> key_range) {
+  MergeWithOutBufferCounting(start_left, start_right, one_past_end_right,
+                             key_range, comp);
+  return ;
+}
+
 template<typename Iterator, typename Compare, typename Distance>
 struct MergeWOBuff {
   inline void operator()(Iterator start_left,
@@ -136,6 +136,7 @@ enum ThreeValue {
 // called.
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline bool Trim2_switch_RAI(RandomAccessIterator &start_left_out,
                              RandomAccessIterator &start_right_out,
                              RandomAccessIterator &one_past_end_out,
@@ -313,6 +314,15 @@ inline bool Trim2_switch_RAI(RandomAccessIterator &start_left_out,
         //                            comp_le(*start_left, *(start_right + 1)));
         //assert(is_endleft_minus1_less_or_equal_to_endright ==
         //                                comp_le(*(end_left - 1), *end_right));
+        if (mwob_namespace::IsUnbalancedMergePreferable<Distance>(length_left,
+                                                               length_right)) {
+          mwob_namespace::MergeUnbalanced_RAI<RandomAccessIterator, Compare,
+                                       Distance, CompareLessOrEqual, ValueType>(
+                                       start_left, start_right, end_right + 1,
+                                       length_left, length_right, comp, comp_le);
+          //assert(std::is_sorted(start_left, end_right + 1, comp));
+          return true;
+        }
         if (length_left >= length_right) {
           jump_to = static_cast<SwitchLabels>(
                     SwitchLabels::length_right_less_than_length_left
@@ -328,20 +338,15 @@ inline bool Trim2_switch_RAI(RandomAccessIterator &start_left_out,
         if (comp(*(symmetric_point_right = end_left + length_left), *start_left)) {
           //assert(!comp_le(*(end_left - 1), *end_right));
           bool is_left_length_less_than_right_length;
-          do {
-            //assert(length_left > 1 && length_right > 1);
-            std::swap_ranges(start_left, start_right, start_right);
-            start_left    = start_right;
-            end_left      = symmetric_point_right;
-            start_right   = symmetric_point_right + 1;
-            length_right -= length_left;
-            //assert(length_left > 1 && end_left != start_left);
-            //assert(comp(*end_right, *end_left));
-            //assert(!comp_le(*(end_left - 1), *end_right));
-            //Note if length_right <= 1 then is_left_length_less_than_right_length
-            // below is false.
-          } while ((is_left_length_less_than_right_length = (length_left < length_right))
-              && comp(*(symmetric_point_right = end_left + length_left), *start_left));
+          start_left  = mwob_namespace::MoveLeftBlockPastSmallerBlocks_RAI(
+                         start_left, start_right, length_left, length_right, comp);
+          start_right = start_left + length_left;
+          end_left    = start_right - 1;
+          //assert(length_left > 1 && end_left != start_left);
+          //assert(comp(*end_right, *end_left));
+          //Note if length_right <= 1 then is_left_length_less_than_right_length
+          // below is false.
+          is_left_length_less_than_right_length = (length_left < length_right);
           is_startleft_less_or_equal_to_startright_plus1 = ThreeValue::Unknown;
           is_startleft_less_or_equal_to_startright
                   = static_cast<ThreeValue>(comp_le(*start_left, *start_right));
@@ -381,24 +386,16 @@ assert(start_right != end_right && start_right != one_past_end);
         RandomAccessIterator symmetric_point_left;
         if (comp(*end_right, *(symmetric_point_left = start_right - length_right))) {
           bool is_right_length_less_than_left;
-          do {
-            //assert(length_left > 1 && length_right > 1);
-            //assert(one_past_end == end_right + 1);
-            std::swap_ranges(start_right, one_past_end, symmetric_point_left);
-            one_past_end = start_right;
-            end_right    = one_past_end - 1;
-            start_right  = symmetric_point_left; //= end_left + 1;
-            //assert((end_left - length_right) == symmetric_point_left - 1);
-            end_left     = symmetric_point_left - 1;
-            length_left -= length_right;
-            //assert(length_left > 0 && length_right > 1);
-            //assert(comp(*start_right, *start_left));
-            //assert(start_right != end_right && start_right != one_past_end);
-            //assert(!comp_le(*start_left, *(start_right + 1)));
-            //Note: if length_left <= 1 then is_right_less_than_left below
-            // is false.
-          } while ((is_right_length_less_than_left = (length_left > length_right)) &&
-             comp(*end_right, *(symmetric_point_left = start_right - length_right)));
+          start_right  = mwob_namespace::MoveRightBlockPastSmallerBlocks_RAI(
+                       start_right, one_past_end, length_left, length_right, comp);
+          one_past_end = start_right + length_right;
+          end_right    = one_past_end - 1;
+          end_left     = start_right - 1;
+          //assert(length_left > 0 && length_right > 1);
+          //assert(comp(*start_right, *start_left));
+          //Note: if length_left <= 1 then is_right_less_than_left below
+          // is false.
+          is_right_length_less_than_left = (length_left > length_right);
           is_endleft_minus1_less_or_equal_to_endright = ThreeValue::Unknown;
           is_endleft_less_or_equal_to_endright
                       = static_cast<ThreeValue>(comp_le(*end_left, *end_right));
@@ -465,7 +462,7 @@ assert(start_right != end_right && start_right != one_past_end);
 
       case SwitchLabels::trivial_case_endright_le_startleft: {
         if (comp(*end_right, *start_left)) {
-          std::rotate(start_left, start_right, one_past_end);
+          mwob_namespace::RotateBlocks(start_left, start_right, one_past_end);
           //assert(std::is_sorted(start_left, one_past_end, comp));
           return true;
         }
@@ -506,14 +503,15 @@ assert(start_right != end_right && start_right != one_past_end);
        // comp_le(start_left_value, end_right_value) (i.e. start_left_value
        // and end_right_value are equivalent under comp).
        //
-       //After the following std::rotate() is executed, the value end_right_value
+       //After the following RotateBlocks() is executed, the value end_right_value
        // will be to the LEFT of the value start_left_value, which means that
        // the merge would not be stable. We correct this by performing another
-       // std::rotate of all values that are equivalent to end_right_value
+       // rotation of all values that are equivalent to end_right_value
        auto location_of_old_start_left
-                            = std::rotate(start_left, start_right, one_past_end);
+                            = mwob_namespace::RotateBlocks(start_left, start_right,
+                                                            one_past_end);
        //assert(std::is_sorted(start_left, one_past_end, comp));
-       std::rotate(location_of_old_start_left - num_const_right,
+       mwob_namespace::RotateBlocks(location_of_old_start_left - num_const_right,
                               //leftmost value is equivalent to end_right_value
                    location_of_old_start_left,
                    location_of_old_start_left + num_const_left); //one past
@@ -705,7 +703,7 @@ inline bool Trim2_switch_bi(BidirectionalIterator &start_left_out,
         if (comp(*symmetric_point_right, *start_left)) {
           bool is_left_length_less_than_right_length;
           do {
-            std::swap_ranges(start_left, start_right, start_right);
+            mwob_namespace::SwapBlocks(start_left, start_right, start_right);
             start_left    = start_right;
             end_left      = symmetric_point_right;
             start_right   = symmetric_point_right;
@@ -760,7 +758,8 @@ inline bool Trim2_switch_bi(BidirectionalIterator &start_left_out,
         if (comp(*end_right, *symmetric_point_left)) {
           bool is_right_length_less_than_left;
           do {
-            std::swap_ranges(start_right, one_past_end, symmetric_point_left);
+            mwob_namespace::SwapBlocks(start_right, one_past_end,
+                                       symmetric_point_left);
             one_past_end = start_right;
             end_right    = one_past_end;
             (void)--end_right;
@@ -842,7 +841,7 @@ inline bool Trim2_switch_bi(BidirectionalIterator &start_left_out,
 
       case SwitchLabels::trivial_case_endright_le_startleft: {
         if (comp(*end_right, *start_left)) {
-          std::rotate(start_left, start_right, one_past_end);
+          mwob_namespace::RotateBlocks(start_left, start_right, one_past_end);
           return true;
         }
         Distance distance_from_start_it_to_first_greater_than;
@@ -870,12 +869,13 @@ inline bool Trim2_switch_bi(BidirectionalIterator &start_left_out,
         //                            std::distance(last_less_than, end_right));
         auto num_const_right = distance_from_end_right_to_last_less_than;
         auto location_of_old_start_left
-                           = std::rotate(start_left, start_right, one_past_end);
+                           = mwob_namespace::RotateBlocks(start_left, start_right,
+                                                           one_past_end);
         auto left_most_value = location_of_old_start_left;
         std::advance(left_most_value, - num_const_right);
         auto one_past_right_most_value = location_of_old_start_left;
         std::advance(one_past_right_most_value, num_const_left);
-        std::rotate(left_most_value,
+        mwob_namespace::RotateBlocks(left_most_value,
                     location_of_old_start_left,
                     one_past_right_most_value);
         return true;
@@ -967,6 +967,7 @@ inline bool Trim2_switch_bi(BidirectionalIterator &start_left_out,
 // (4) If is_left_trimmed == false then comp(*end_right,   *end_left)
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 void MergeWithOutBuffer2_recursive_RAI(RandomAccessIterator start_left,
                      RandomAccessIterator start_right,
                      RandomAccessIterator one_past_end,
@@ -977,7 +978,25 @@ void MergeWithOutBuffer2_recursive_RAI(RandomAccessIterator start_left,
                      ThreeValue is_startleft_less_or_equal_to_startright,
                      ThreeValue is_startleft_less_or_equal_to_startright_plus1,
                      ThreeValue is_endleft_less_or_equal_to_endright,
-                     ThreeValue is_endleft_minus1_less_or_equal_to_endright) {
+                     ThreeValue is_endleft_minus1_less_or_equal_to_endright,
+                     mwob_namespace::MergeWatchdog &watchdog,
+                     std::uintmax_t depth) {
+  if (watchdog.ShouldFallBack(depth, static_cast<std::uintmax_t>(
+                   length_left < length_right ? length_left : length_right))) {
+    mwob_namespace::MergeByRotations<RandomAccessIterator, Compare, Distance>(
+        start_left, start_right, one_past_end, length_left, length_right, comp);
+    return ;
+  }
+  if constexpr (MWOB_MERGE_NETWORK_MAX_LENGTH > 0 &&
+                mwob_namespace::IsMergeNetworkUsable<ValueType, Compare>::value) {
+    if (length_left  <= MWOB_MERGE_NETWORK_MAX_LENGTH &&
+        length_right <= MWOB_MERGE_NETWORK_MAX_LENGTH &&
+        !mwob_namespace::IsConstantEvaluated()) {
+      mwob_namespace::MergeByNetwork(start_left, length_left, length_right,
+                                     comp);
+      return ;
+    }
+  }
   //assert(length_left > 0 && length_right > 0);
   //assert(comp(*start_right, *(start_right - 1)));
   //if (is_startleft_less_or_equal_to_startright >= 0)
@@ -1002,6 +1021,11 @@ void MergeWithOutBuffer2_recursive_RAI(RandomAccessIterator start_left,
     //assert(std::is_sorted(start_left, one_past_end, comp));
     return ; //The two non-decreasing sequences have been merged.
   }
+  if constexpr (mwob_namespace::IsSharedPrefixCompare<Compare,
+                                                      ValueType>::value) {
+    if (length_left + length_right >= MWOB_SHARED_PREFIX_MIN_LENGTH)
+      mwob_namespace::RaiseSharedPrefixLength_RAI(start_right, comp, comp_le);
+  }
   //assert(length_left  == std::distance(start_left,  start_right));
   //assert(length_right == std::distance(start_right, one_past_end));
   auto length_smaller = length_left < length_right ? length_left : length_right;
@@ -1011,7 +1035,7 @@ void MergeWithOutBuffer2_recursive_RAI(RandomAccessIterator start_left,
   //assert(d > 0 && d < length_smaller);
   {
     auto start_2nd_quarter = start_right - d;
-    std::swap_ranges(start_2nd_quarter, start_right, start_right);
+    mwob_namespace::SwapBlocks(start_2nd_quarter, start_right, start_right);
     //auto one_past_end_2nd_quarter = start_right;
     //Distance length_first_quarter = length_left - d;
     MergeWithOutBuffer2_recursive_RAI<RandomAccessIterator, Compare, Distance,
@@ -1019,7 +1043,8 @@ void MergeWithOutBuffer2_recursive_RAI(RandomAccessIterator start_left,
       start_left, start_2nd_quarter, start_right, length_left - d, d,
       comp, comp_le,
       ThreeValue::False, ThreeValue::False, ThreeValue::Unknown,
-      ThreeValue::Unknown);
+      ThreeValue::Unknown,
+      watchdog, depth + 1);
   }
   //auto start_4th_quarter = start_right + d;
   //Distance length_4th_quarter = length_right - d;
@@ -1028,7 +1053,8 @@ void MergeWithOutBuffer2_recursive_RAI(RandomAccessIterator start_left,
     start_right, start_right + d, one_past_end, d, length_right - d,
     comp, comp_le,
     ThreeValue::Unknown, ThreeValue::Unknown, ThreeValue::False,
-    ThreeValue::False);
+    ThreeValue::False,
+    watchdog, depth + 1);
   return ;
 }
 
@@ -1047,7 +1073,15 @@ void MergeWithOutBuffer2_recursive_bi(BidirectionalIterator start_left,
                       ThreeValue is_startleft_less_or_equal_to_startright,
                       ThreeValue is_startleft_less_or_equal_to_startright_plus1,
                       ThreeValue is_endleft_less_or_equal_to_endright,
-                      ThreeValue is_endleft_minus1_less_or_equal_to_endright) {
+                      ThreeValue is_endleft_minus1_less_or_equal_to_endright,
+                      mwob_namespace::MergeWatchdog &watchdog,
+                      std::uintmax_t depth) {
+  if (watchdog.ShouldFallBack(depth, static_cast<std::uintmax_t>(
+                   length_left < length_right ? length_left : length_right))) {
+    mwob_namespace::MergeByRotations<BidirectionalIterator, Compare, Distance>(
+        start_left, start_right, one_past_end, length_left, length_right, comp);
+    return ;
+  }
   BidirectionalIterator start_2nd_quarter, start_4th_quarter;
   Distance d;
   //assert(comp(*start_right, *(start_right - 1)));
@@ -1070,7 +1104,8 @@ void MergeWithOutBuffer2_recursive_bi(BidirectionalIterator start_left,
   {
     //auto start_2nd_quarter = start_right - d;
     auto one_past_end_2nd_quarter = start_right;
-    std::swap_ranges(start_2nd_quarter, one_past_end_2nd_quarter, start_right);
+    mwob_namespace::SwapBlocks(start_2nd_quarter, one_past_end_2nd_quarter,
+                               start_right);
     Distance length_first_quarter = length_left - d;
 
     MergeWithOutBuffer2_recursive_bi<BidirectionalIterator, Compare, Distance,
@@ -1078,7 +1113,8 @@ void MergeWithOutBuffer2_recursive_bi(BidirectionalIterator start_left,
       start_left, start_2nd_quarter, start_right, length_first_quarter, d,
       comp, comp_le,
       ThreeValue::False, ThreeValue::False, ThreeValue::Unknown,
-      ThreeValue::Unknown);
+      ThreeValue::Unknown,
+      watchdog, depth + 1);
   }
   //auto start_4th_quarter = start_right; std::advance(start_4th_quarter, d);
   Distance length_4th_quarter = length_right - d;
@@ -1087,7 +1123,8 @@ void MergeWithOutBuffer2_recursive_bi(BidirectionalIterator start_left,
     start_right, start_4th_quarter, one_past_end, d, length_4th_quarter,
     comp, comp_le,
     ThreeValue::Unknown, ThreeValue::Unknown, ThreeValue::False,
-    ThreeValue::False);
+    ThreeValue::False,
+    watchdog, depth + 1);
   //assert(std::is_sorted(start_left, one_past_end, comp));
   return ;
 }
@@ -1100,6 +1137,7 @@ void MergeWithOutBuffer2_recursive_bi(BidirectionalIterator start_left,
 // (3) comp(*start_right, *end_left)
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2_RAI(RandomAccessIterator start_left,
                                     RandomAccessIterator end_left,
                                     RandomAccessIterator start_right,
@@ -1117,12 +1155,15 @@ inline void MergeWithOutBuffer2_RAI(RandomAccessIterator start_left,
                 start_left, end_left, *start_right, length_left, comp, comp_le);
   }
   //assert(length_left > 0 && length_right > 0);
+  mwob_namespace::MergeWatchdog watchdog(
+                    static_cast<std::uintmax_t>(length_left + length_right));
   MergeWithOutBuffer2_recursive_RAI<RandomAccessIterator, Compare, Distance,
                                     CompareLessOrEqual, ValueType>(
                                start_left, start_right, one_past_end,
                                length_left, length_right, comp, comp_le,
                                ThreeValue::False, ThreeValue::Unknown,
-                               ThreeValue::Unknown, ThreeValue::Unknown);
+                               ThreeValue::Unknown, ThreeValue::Unknown,
+                               watchdog, 0);
   return ;
 }
 
@@ -1143,17 +1184,21 @@ inline void MergeWithOutBuffer2_bi(BidirectionalIterator start_left,
     Compare, Distance, CompareLessOrEqual, ValueType>(start_left, end_left,
                                       start_right, length_left, comp, comp_le);
   }
+  mwob_namespace::MergeWatchdog watchdog(
+                    static_cast<std::uintmax_t>(length_left + length_right));
   MergeWithOutBuffer2_recursive_bi<BidirectionalIterator, Compare, Distance,
                                     CompareLessOrEqual, ValueType>(
                                start_left, start_right, one_past_end,
                                length_left, length_right, comp, comp_le,
                                ThreeValue::False, ThreeValue::Unknown,
-                               ThreeValue::Unknown, ThreeValue::Unknown);
+                               ThreeValue::Unknown, ThreeValue::Unknown,
+                               watchdog, 0);
   return ;
 }
 
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(RandomAccessIterator start_left,
                                 RandomAccessIterator end_left,
                                 RandomAccessIterator start_right,
@@ -1163,9 +1208,23 @@ inline void MergeWithOutBuffer2(RandomAccessIterator start_left,
                                 Compare comp,
                                 CompareLessOrEqual comp_le,
                                 std::random_access_iterator_tag) {
-  MergeWithOutBuffer2_RAI<RandomAccessIterator, Compare, Distance,
-    CompareLessOrEqual, ValueType>(start_left, end_left, start_right,
-        one_past_end, length_left, length_right, comp, comp_le);
+  if constexpr (!std::is_pointer<RandomAccessIterator>::value &&
+        mwob_namespace::IsContiguousIterator<RandomAccessIterator>::value) {
+    //Lower contiguous iterators (e.g. std::vector<T>::iterator) to pointers.
+    auto start_left_ptr = mwob_namespace::IteratorToPointer(start_left);
+    typedef decltype(start_left_ptr) Pointer;
+    Pointer end_left_ptr     = mwob_namespace::IteratorToPointer(end_left);
+    Pointer start_right_ptr  = mwob_namespace::IteratorToPointer(start_right);
+    Pointer one_past_end_ptr = start_right_ptr + (one_past_end - start_right);
+    MergeWithOutBuffer2_RAI<Pointer, Compare, Distance,
+      CompareLessOrEqual, ValueType>(start_left_ptr, end_left_ptr,
+          start_right_ptr, one_past_end_ptr, length_left, length_right,
+          comp, comp_le);
+  } else {
+    MergeWithOutBuffer2_RAI<RandomAccessIterator, Compare, Distance,
+      CompareLessOrEqual, ValueType>(start_left, end_left, start_right,
+          one_past_end, length_left, length_right, comp, comp_le);
+  }
   return ;
 }
 
@@ -1192,7 +1251,9 @@ inline void MergeWithOutBuffer2(BidirectionalIterator start_left,
 
 //Primary dispatch function
 template<typename Iterator, typename Compare,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(Iterator start_left,
                                 Iterator start_right,
                                 Iterator one_past_end_right,
@@ -1201,11 +1262,9 @@ inline void MergeWithOutBuffer2(Iterator start_left,
                                 Compare comp) {
   if (start_left == start_right || start_right == one_past_end_right)
     return ;
-  typedef typename Iterator::value_type ValueType;
-  auto comp_le = [comp](const ValueType &lhs, const ValueType &rhs) -> bool {
-    return !comp(rhs, lhs);
-  };
-  typedef decltype(comp_le) CompareLessOrEqual;
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+  typedef mwob_namespace::ComplementCompare<Compare> CompareLessOrEqual;
+  CompareLessOrEqual comp_le(comp);
   Iterator end_left = start_right;
   (void)--end_left;
   if (comp_le(*end_left, *start_right)) //i.e. if *end_left <= *start_right
@@ -1223,13 +1282,15 @@ inline void MergeWithOutBuffer2(Iterator start_left,
 //Overloads of the above primary dispatch function
 
 template<typename Iterator,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(Iterator start_left,
                                 Iterator start_right,
                                 Iterator one_past_end_right,
                                 Distance length_left,
                                 Distance length_right) {
-	  typedef typename Iterator::value_type ValueType;
+	  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
 	  auto comp = std::less<ValueType>();
 	  typedef decltype(comp) Compare;
 	  MergeWithOutBuffer2<Iterator, Compare, Distance>(
@@ -1239,7 +1300,9 @@ inline void MergeWithOutBuffer2(Iterator start_left,
 }
 
 template<typename Iterator, typename Compare,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(Iterator start_left,
                                 Iterator start_right,
                                 Iterator one_past_end_right,
@@ -1254,11 +1317,13 @@ inline void MergeWithOutBuffer2(Iterator start_left,
 
 
 template<typename Iterator,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(Iterator start_left,
                                 Iterator start_right,
                                 Iterator one_past_end_right) {
-  typedef typename Iterator::value_type ValueType;
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
   auto comp = std::less<ValueType>();
   typedef decltype(comp) Compare;
   MergeWithOutBuffer2<Iterator, Compare, Distance>(
@@ -1267,7 +1332,9 @@ inline void MergeWithOutBuffer2(Iterator start_left,
 }
 
 template<typename Iterator, typename Compare,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(Iterator start_left,
                                 Iterator one_past_end_left,
                                 Iterator start_right,
@@ -1282,12 +1349,14 @@ inline void MergeWithOutBuffer2(Iterator start_left,
 }
 
 template<typename Iterator,
-         typename Distance = typename Iterator::difference_type>
+         typename Distance =
+                  typename std::iterator_traits<Iterator>::difference_type>
+MWOB_CONSTEXPR20
 inline void MergeWithOutBuffer2(Iterator start_left,
                                 Iterator one_past_end_left,
                                 Iterator start_right,
                                 Iterator one_past_end_right) {
-	  typedef typename Iterator::value_type ValueType;
+	  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
 	  auto comp = std::less<ValueType>();
 	  typedef decltype(comp) Compare;
 	  MergeWithOutBuffer2<Iterator, Compare, Distance>(
@@ -0,0 +1,140 @@
+/*
+ * merge_without_buffer_async.h
+ *
+ *  MergeWithOutBufferAsync() runs a merge on a caller supplied executor and
+ *   returns a std::future<bool> whose value is true if and only if the merge
+ *   ran to completion (i.e. it was not cancelled).
+ *
+ *  The merge is performed by an IncrementalMergeWithOutBuffer (see
+ *   merge_without_buffer_incremental.h) in slices of work_quantum units of
+ *   work. Cancellation is cooperative: the MergeCancellationToken is checked
+ *   between slices and, once cancellation is requested, the merge stops at
+ *   the first subproblem boundary (i.e. it only finishes the partially
+ *   performed swap, if any, by IncrementalMergeWithOutBuffer::
+ *   FinishPartialSwap()).
+ *
+ *  Guarantee if the merge is cancelled: [start_left, one_past_end) is a
+ *   permutation of its original elements and it is a sequence of consecutive
+ *   blocks such that
+ *  (1) every element of a block is less than or equal to every element of
+ *      every block to its right, and
+ *  (2) each block either is sorted or consists of two adjacent sorted lists.
+ *  In particular, every element is already within the block that contains
+ *   its final (merged) position, and merging each two-list block (e.g. by
+ *   MergeWithOutBuffer1()) would finish the merge.
+ *
+ *  Assumes that: the range is not accessed by anything else, and is not
+ *   destroyed, until the future becomes ready. Destroying (or never waiting
+ *   on) the future does not wait for or cancel the task, so the caller must
+ *   wait on the future (e.g. by get()) before the range goes out of scope
+ *   and before main() returns, even after requesting cancellation.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  MergeCancellationToken token;
+  std::future<bool> result = MergeWithOutBufferAsync(NewThreadExecutor(),
+                        vec.begin(), vec.begin() + length_left, vec.end(),
+                        std::less<int>(), token);
+  ...
+  token.RequestCancellation(); //E.g. because a newer merge supersedes this one.
+  bool was_completed = result.get();
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_ASYNC_H_
+#define SRC_MERGE_WITHOUT_BUFFER_ASYNC_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "merge_without_buffer_incremental.h"
+
+#ifndef MWOB_ASYNC_DEFAULT_WORK_QUANTUM
+#define MWOB_ASYNC_DEFAULT_WORK_QUANTUM (1 << 16)
+#endif
+
+//Copies of a MergeCancellationToken share the same cancellation state.
+class MergeCancellationToken {
+public:
+  MergeCancellationToken()
+      : is_cancellation_requested_(std::make_shared<std::atomic<bool>>(false)) {
+  }
+
+  void RequestCancellation() const {
+    is_cancellation_requested_->store(true, std::memory_order_relaxed);
+    return ;
+  }
+
+  bool IsCancellationRequested() const {
+    return is_cancellation_requested_->load(std::memory_order_relaxed);
+  }
+
+private:
+  std::shared_ptr<std::atomic<bool>> is_cancellation_requested_;
+};
+
+//An executor that runs each task on its own (detached) std::thread. Since
+// the thread is detached, nothing but the returned future tells the caller
+// when the task has finished (see the lifetime requirement above).
+//Any callable that accepts a std::function<void()> may be used as an executor
+// (e.g. a thread pool's submit function wrapped in a lambda).
+struct NewThreadExecutor {
+  inline void operator()(std::function<void()> task) const {
+    std::thread(std::move(task)).detach();
+    return ;
+  }
+};
+
+template<typename Executor, typename RandomAccessIterator, typename Compare>
+inline std::future<bool> MergeWithOutBufferAsync(Executor &&executor,
+                    RandomAccessIterator start_left,
+                    RandomAccessIterator start_right,
+                    RandomAccessIterator one_past_end,
+                    Compare comp,
+                    MergeCancellationToken token = MergeCancellationToken(),
+                    std::size_t work_quantum = MWOB_ASYNC_DEFAULT_WORK_QUANTUM) {
+  auto promise = std::make_shared<std::promise<bool>>();
+  std::future<bool> future = promise->get_future();
+  std::function<void()> task =
+      [promise, start_left, start_right, one_past_end, comp, token,
+       work_quantum]() {
+    try {
+      IncrementalMergeWithOutBuffer<RandomAccessIterator, Compare> merge(
+                               start_left, start_right, one_past_end, comp);
+      while (!merge.Step(work_quantum)) {
+        if (token.IsCancellationRequested()) {
+          merge.FinishPartialSwap();
+          break ;
+        }
+      }
+      promise->set_value(merge.IsDone());
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+    return ;
+  };
+  std::forward<Executor>(executor)(std::move(task));
+  return future;
+}
+
+template<typename Executor, typename RandomAccessIterator>
+inline std::future<bool> MergeWithOutBufferAsync(Executor &&executor,
+                    RandomAccessIterator start_left,
+                    RandomAccessIterator start_right,
+                    RandomAccessIterator one_past_end) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  return MergeWithOutBufferAsync(std::forward<Executor>(executor), start_left,
+                         start_right, one_past_end, std::less<ValueType>());
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_ASYNC_H_ */
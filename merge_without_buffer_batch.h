@@ -0,0 +1,330 @@
+/*
+ * merge_without_buffer_batch.h
+ *
+ *  MergeWithOutBufferBatch() performs many independent merges in one call.
+ *  When the merges are tiny (e.g. tens of elements each) the per call
+ *   dispatch and setup done by MergeWithOutBuffer1() dominates the run time,
+ *   so the batch is processed in the following phases:
+ *  (1) In one pass over the jobs, the jobs that are empty or already ordered
+ *      (i.e. *end_left <= *start_right) are skipped and the jobs whose right
+ *      list is entirely less than its left list (i.e.
+ *      *end_right < *start_left) are finished with a single rotation.
+ *  (2) The remaining jobs are grouped by size class.
+ *  (3) Each group is handed to a kernel specialized to its size class:
+ *       tiny jobs are merged by insertion, small jobs by the random access
+ *       implementation of MergeWithOutBuffer1(), and large jobs by the
+ *       random access implementation of MergeWithOutBuffer2().
+ *  If num_threads > 1 then the jobs are split into num_threads contiguous
+ *   chunks, each of which is processed (as above) by its own thread.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> vec1({ 3, 4, 7, 1, 5 }), vec2({ 2, 9, 0, 8 });
+  typedef std::vector<int>::iterator Iterator;
+  std::vector<MergeWithOutBufferJob<Iterator>> jobs;
+  jobs.push_back({ vec1.begin(), vec1.begin() + 3, vec1.end() });
+  jobs.push_back({ vec2.begin(), vec2.begin() + 2, vec2.end() });
+  MergeWithOutBufferBatch(jobs.begin(), jobs.end(), std::less<int>());
+  //Now vec1 == { 1, 3, 4, 5, 7 } and vec2 == { 0, 2, 8, 9 }.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_BATCH_H_
+#define SRC_MERGE_WITHOUT_BUFFER_BATCH_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "merge_without_buffer_common.h"
+#include "merge_without_buffer1.h"
+#include "merge_without_buffer2.h"
+
+//Jobs whose total length is at most this are merged by insertion.
+#ifndef MWOB_BATCH_TINY_LENGTH
+#define MWOB_BATCH_TINY_LENGTH 24
+#endif
+//Jobs whose total length is at most this (and that are not tiny) are merged
+// by MergeWithOutBuffer1_RAI(); longer jobs by MergeWithOutBuffer2_RAI().
+#ifndef MWOB_BATCH_SMALL_LENGTH
+#define MWOB_BATCH_SMALL_LENGTH 512
+#endif
+
+//A single merge job: [start_left, start_right) and
+// [start_right, one_past_end) are sorted lists that are to be merged.
+template<typename Iterator>
+struct MergeWithOutBufferJob {
+  typedef Iterator iterator_type;
+  Iterator start_left;
+  Iterator start_right;
+  Iterator one_past_end;
+};
+
+namespace merge_without_buffer_batch_namespace {
+
+enum class BatchSizeClass : unsigned char {
+  Tiny = 0,
+  Small,
+  Large,
+  NumberOfSizeClasses
+};
+
+template<typename Compare, typename ValueType>
+struct CompareLessOrEqualFromCompare {
+  Compare comp;
+  inline bool operator()(const ValueType &lhs, const ValueType &rhs) const {
+    return !comp(rhs, lhs);
+  }
+};
+
+/* Merges [start_left, start_right) and [start_right, one_past_end) by
+ *  inserting the elements of the right list, from left to right, into place.
+ * Stops as soon as an element of the right list is already in place (since
+ *  all remaining elements of the right list must then also be in place).
+ * Assumes that: both lists are non-empty.
+ */
+template<typename RandomAccessIterator, typename Compare>
+inline void MergeByInsertion_RAI(RandomAccessIterator start_left,
+                                 RandomAccessIterator start_right,
+                                 RandomAccessIterator one_past_end,
+                                 Compare comp) {
+  for (auto it = start_right; it != one_past_end; (void)++it) {
+    auto previous = it - 1;
+    if (!comp(*it, *previous))
+      return ;
+    auto value = std::move(*it);
+    auto hole  = it;
+    do {
+      *hole = std::move(*previous);
+      hole  = previous;
+    } while (hole != start_left && comp(value, *(--previous)));
+    *hole = std::move(value);
+  }
+  return ;
+}
+
+/* Processes the jobs in [first_job, one_past_last_job) as described at the
+ *  top of this file.
+ * Assumes that: the jobs are pairwise independent (i.e. no two jobs refer to
+ *  overlapping ranges).
+ */
+template<typename JobIterator, typename Compare>
+inline void MergeWithOutBufferBatch_RAI(JobIterator first_job,
+                                        JobIterator one_past_last_job,
+                                        Compare comp) {
+  typedef typename std::iterator_traits<JobIterator>::value_type Job;
+  typedef typename Job::iterator_type Iterator;
+  typedef typename std::iterator_traits<Iterator>::difference_type Distance;
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+  typedef CompareLessOrEqualFromCompare<Compare, ValueType> CompareLessOrEqual;
+  CompareLessOrEqual comp_le{comp};
+  constexpr std::size_t num_size_classes =
+             static_cast<std::size_t>(BatchSizeClass::NumberOfSizeClasses);
+  std::vector<JobIterator> size_class_jobs[num_size_classes];
+
+  //Phase 1: bulk fast paths and grouping by size class.
+  for (auto job = first_job; job != one_past_last_job; (void)++job) {
+    Iterator start_left   = job->start_left;
+    Iterator start_right  = job->start_right;
+    Iterator one_past_end = job->one_past_end;
+    if (start_left == start_right || start_right == one_past_end)
+      continue ;
+    if (comp_le(*(start_right - 1), *start_right)) //Already ordered.
+      continue ;
+    if (comp(*(one_past_end - 1), *start_left)) {  //Right < left.
+      std::rotate(start_left, start_right, one_past_end);
+      continue ;
+    }
+    Distance length = one_past_end - start_left;
+    BatchSizeClass size_class = BatchSizeClass::Large;
+    if (length <= static_cast<Distance>(MWOB_BATCH_TINY_LENGTH))
+      size_class = BatchSizeClass::Tiny;
+    else if (length <= static_cast<Distance>(MWOB_BATCH_SMALL_LENGTH))
+      size_class = BatchSizeClass::Small;
+    size_class_jobs[static_cast<std::size_t>(size_class)].push_back(job);
+  }
+
+  //Phase 2: dispatch each size class to its kernel.
+  for (auto job : size_class_jobs[static_cast<std::size_t>(
+                                                      BatchSizeClass::Tiny)]) {
+    MergeByInsertion_RAI<Iterator, Compare>(job->start_left, job->start_right,
+                                            job->one_past_end, comp);
+  }
+  for (auto job : size_class_jobs[static_cast<std::size_t>(
+                                                     BatchSizeClass::Small)]) {
+    merge_without_buffer_1_namespace::MergeWithOutBuffer1<Iterator, Compare,
+                                     Distance, CompareLessOrEqual, ValueType>(
+        job->start_left, job->start_right - 1, job->start_right,
+        job->one_past_end, job->start_right - job->start_left,
+        job->one_past_end - job->start_right, comp, comp_le,
+        std::random_access_iterator_tag());
+  }
+  for (auto job : size_class_jobs[static_cast<std::size_t>(
+                                                     BatchSizeClass::Large)]) {
+    merge_without_buffer_2_namespace::MergeWithOutBuffer2<Iterator, Compare,
+                                     Distance, CompareLessOrEqual, ValueType>(
+        job->start_left, job->start_right - 1, job->start_right,
+        job->one_past_end, job->start_right - job->start_left,
+        job->one_past_end - job->start_right, comp, comp_le,
+        std::random_access_iterator_tag());
+  }
+  return ;
+}
+
+template<typename JobIterator, typename Compare>
+inline void MergeWithOutBufferBatch_bi(JobIterator first_job,
+                                       JobIterator one_past_last_job,
+                                       Compare comp) {
+  for (auto job = first_job; job != one_past_last_job; (void)++job) {
+    MergeWithOutBuffer2(job->start_left, job->start_right, job->one_past_end,
+                        comp);
+  }
+  return ;
+}
+
+template<typename JobIterator, typename Compare>
+inline void MergeWithOutBufferBatch(JobIterator first_job,
+                                    JobIterator one_past_last_job,
+                                    Compare comp,
+                                    std::random_access_iterator_tag) {
+  MergeWithOutBufferBatch_RAI<JobIterator, Compare>(first_job,
+                                                    one_past_last_job, comp);
+  return ;
+}
+
+template<typename JobIterator, typename Compare>
+inline void MergeWithOutBufferBatch(JobIterator first_job,
+                                    JobIterator one_past_last_job,
+                                    Compare comp,
+                                    std::bidirectional_iterator_tag) {
+  MergeWithOutBufferBatch_bi<JobIterator, Compare>(first_job,
+                                                   one_past_last_job, comp);
+  return ;
+}
+
+template<typename JobIterator, typename Compare>
+inline void MergeWithOutBufferBatch_SingleThread(JobIterator first_job,
+                                                JobIterator one_past_last_job,
+                                                Compare comp) {
+  typedef typename std::iterator_traits<JobIterator>::value_type Job;
+  typedef typename Job::iterator_type Iterator;
+  MergeWithOutBufferBatch<JobIterator, Compare>(first_job, one_past_last_job,
+       comp, typename std::iterator_traits<Iterator>::iterator_category());
+  return ;
+}
+
+//Joins every joinable thread in threads when it is destroyed, so that no
+// exit path (including an exception thrown while starting the threads or
+// while the calling thread merges its own chunk) destroys a joinable
+// std::thread, which would call std::terminate().
+struct ThreadJoiner {
+  explicit ThreadJoiner(std::vector<std::thread> &threads_in)
+      : threads(threads_in) {}
+  ~ThreadJoiner() {
+    for (auto &thread : threads) {
+      if (thread.joinable())
+        thread.join();
+    }
+  }
+  ThreadJoiner(const ThreadJoiner &) = delete;
+  ThreadJoiner &operator=(const ThreadJoiner &) = delete;
+  std::vector<std::thread> &threads;
+};
+
+} //END namespace: merge_without_buffer_batch_namespace
+
+/* Merges each job in [first_job, one_past_last_job), where each job is a
+ *  MergeWithOutBufferJob<Iterator> (or any type with an iterator_type typedef
+ *  and start_left, start_right, and one_past_end members).
+ * If num_threads == 0 then std::thread::hardware_concurrency() threads are
+ *  used. The calling thread processes the first chunk of jobs.
+ * If comp (or a move) throws while a chunk is being processed then the
+ *  exception is caught, the other chunks are still processed, and once every
+ *  thread has been joined the exception of the first such chunk is rethrown.
+ *  If a thread cannot be started then the threads that were started are
+ *  joined and the std::system_error is rethrown. In either case the jobs
+ *  that were not finished are left in a valid but unspecified order.
+ * Assumes that: the jobs are pairwise independent (i.e. no two jobs refer to
+ *  overlapping ranges).
+ */
+template<typename JobIterator, typename Compare>
+inline void MergeWithOutBufferBatch(JobIterator first_job,
+                                    JobIterator one_past_last_job,
+                                    Compare comp,
+                                    std::size_t num_threads = 1) {
+  std::size_t num_jobs = static_cast<std::size_t>(
+                                std::distance(first_job, one_past_last_job));
+  if (num_threads == 0)
+    num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(),
+                                        1);
+  if (num_threads > num_jobs)
+    num_threads = num_jobs;
+  if (num_threads <= 1) {
+    merge_without_buffer_batch_namespace::MergeWithOutBufferBatch_SingleThread<
+                     JobIterator, Compare>(first_job, one_past_last_job, comp);
+    return ;
+  }
+  using merge_without_buffer_batch_namespace::
+                                    MergeWithOutBufferBatch_SingleThread;
+  //exceptions[i] holds the exception thrown while processing the i-th chunk.
+  std::vector<std::exception_ptr> exceptions(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  {
+    merge_without_buffer_batch_namespace::ThreadJoiner joiner(threads);
+    std::size_t jobs_per_thread = num_jobs / num_threads;
+    std::size_t remainder       = num_jobs % num_threads;
+    JobIterator chunk_start = first_job;
+    JobIterator first_chunk_end;
+    for (std::size_t i = 0; i < num_threads; i++) {
+      JobIterator chunk_end = chunk_start;
+      std::advance(chunk_end, jobs_per_thread + (i < remainder ? 1 : 0));
+      if (i == 0) {
+        first_chunk_end = chunk_end;
+      } else {
+        threads.emplace_back([chunk_start, chunk_end, comp,
+                              &exception = exceptions[i]]() {
+          try {
+            MergeWithOutBufferBatch_SingleThread<JobIterator, Compare>(
+                                                chunk_start, chunk_end, comp);
+          } catch (...) {
+            exception = std::current_exception();
+          }
+        });
+      }
+      chunk_start = chunk_end;
+    }
+    try {
+      MergeWithOutBufferBatch_SingleThread<JobIterator, Compare>(first_job,
+                                                     first_chunk_end, comp);
+    } catch (...) {
+      exceptions[0] = std::current_exception();
+    }
+  } //joiner joins the threads here.
+  for (auto &exception : exceptions) {
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+  return ;
+}
+
+template<typename JobIterator>
+inline void MergeWithOutBufferBatch(JobIterator first_job,
+                                    JobIterator one_past_last_job) {
+  typedef typename std::iterator_traits<JobIterator>::value_type Job;
+  typedef typename Job::iterator_type Iterator;
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+  MergeWithOutBufferBatch(first_job, one_past_last_job,
+                          std::less<ValueType>());
+  return ;
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_BATCH_H_ */
@@ -0,0 +1,456 @@
+/*
+ * merge_without_buffer_block_exchange.h
+ *
+ *  The block exchange kernels that are used by the swap and rotate sites of
+ *   the _RAI and _bi recursions of MergeWithOutBuffer1() and
+ *   MergeWithOutBuffer2().
+ *
+ *  std::swap_ranges() and std::rotate() move every element about three times
+ *   (once into a temporary, once into its destination, and once out of the
+ *   temporary), which is cheap for trivially copyable types but not for
+ *   types whose moves are expensive. For such types RotateByCycles_RAI()
+ *   instead moves the elements along the cycles of the rotation through a
+ *   single held element (i.e. by "hole" chaining, like RotateLeftBy1()), so
+ *   that rotating N elements takes N + gcd(N, length of the first block)
+ *   moves.
+ *  The trims in Trim1_switch_RAI() and Trim2_switch_RAI() repeatedly swap the
+ *   shorter list with the equally long block of the longer list next to it.
+ *   For an exchange of two blocks of equal length every cycle has length 2,
+ *   so nothing can be saved by exchanging them one at a time. The kernels
+ *   below therefore first find out how many such swaps would be performed
+ *   and then perform all of them at once as a single rotation, which takes
+ *   about one move per element instead of three moves per element per swap.
+ *
+ *  Whether or not the move minimizing kernels are used is decided per value
+ *   type by the trait mwob_namespace::UseMoveMinimizingBlockExchange<T>,
+ *   which by default is true exactly when T is not trivially copyable. It may
+ *   be specialized, e.g.
+ *
+ *    template<> struct mwob_namespace::UseMoveMinimizingBlockExchange<Key>
+ *       : std::true_type {};
+ *
+ *  Cycle chasing needs random access iterators so for bidirectional
+ *   iterators the kernels always use std::swap_ranges() and std::rotate().
+ *
+ *  For trivially copyable types stored contiguously (the public RAI entry
+ *   points lower contiguous iterators to pointers, so within the recursions
+ *   these are exactly the pointer iterators) blocks of at least
+ *   MWOB_TILED_SWAP_MIN_BYTES bytes are instead exchanged by
+ *   SwapBlocksTiled_ptr(), which swaps the two blocks' bytes one tile of
+ *   MWOB_SWAP_TILE_BYTES bytes at a time using 16 byte (SSE2) loads and
+ *   stores. Once the blocks are larger than MWOB_LLC_SIZE_BYTES (so that the
+ *   swap is bound by memory bandwidth) the next tile of both blocks is
+ *   prefetched while the current one is swapped and, if
+ *   MWOB_USE_NON_TEMPORAL_STORES is non-zero, the stores bypass the cache.
+ *   Non-temporal stores are off by default since they only pay off on
+ *   machines whose caches are much smaller than the blocks being swapped.
+ *  RotateBlocksTiled_ptr() rotates by the Gries-Mills block swap algorithm
+ *   on top of SwapBlocksTiled_ptr() until the shorter block fits in
+ *   MWOB_ROTATE_STACK_BYTES bytes, after which RotateThroughStackArray_ptr()
+ *   copies it to the stack and moves the longer block with a single
+ *   std::memmove(), so that a short block is never swapped element by
+ *   element across a long one. For such types the trims likewise perform
+ *   their repeated swaps as a single rotation.
+ *  RotateWithOutBuffer() (in merge_without_buffer_rotate.h) makes this
+ *   rotation available on its own.
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_BLOCK_EXCHANGE_H_
+#define SRC_MERGE_WITHOUT_BUFFER_BLOCK_EXCHANGE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//Blocks of trivially copyable values whose size in bytes is at least this
+// are swapped by mwob_namespace::SwapBlocksTiled_ptr().
+#ifndef MWOB_TILED_SWAP_MIN_BYTES
+#define MWOB_TILED_SWAP_MIN_BYTES 256
+#endif
+#ifndef MWOB_SWAP_TILE_BYTES
+#define MWOB_SWAP_TILE_BYTES 16384
+#endif
+//The size of the last level cache. Blocks larger than this are prefetched
+// one tile ahead (and optionally written with non-temporal stores).
+#ifndef MWOB_LLC_SIZE_BYTES
+#define MWOB_LLC_SIZE_BYTES (32 * 1024 * 1024)
+#endif
+#ifndef MWOB_USE_NON_TEMPORAL_STORES
+#define MWOB_USE_NON_TEMPORAL_STORES 0
+#endif
+//Rotations of trivially copyable values stored contiguously whose shorter
+// block is at most this many bytes are performed by
+// mwob_namespace::RotateThroughStackArray_ptr() (0 disables this).
+#ifndef MWOB_ROTATE_STACK_BYTES
+#define MWOB_ROTATE_STACK_BYTES 1024
+#endif
+
+//MWOB_CONSTEXPR20 marks the functions that make up the _RAI recursions of
+// MergeWithOutBuffer1() and MergeWithOutBuffer2() (and so their dispatch
+// functions) as constexpr when the standard library allows it, i.e. under
+// C++20 where std::swap_ranges(), std::rotate(), std::upper_bound(), etc. and
+// std::is_constant_evaluated() are constexpr. This allows a merge to be
+// performed at compile time, e.g. on a std::array.
+#ifndef MWOB_CONSTEXPR20
+#if defined(__cpp_lib_constexpr_algorithms) && \
+    defined(__cpp_lib_is_constant_evaluated)
+#define MWOB_CONSTEXPR20 constexpr
+#else
+#define MWOB_CONSTEXPR20
+#endif
+#endif
+
+namespace mwob_namespace {
+
+//Returns true if it is being evaluated at compile time, in which case the
+// tiled kernels (which use memcpy() and SIMD intrinsics) and the merge
+// networks' table of function pointers must not be used.
+constexpr bool IsConstantEvaluated() {
+#if defined(__cpp_lib_is_constant_evaluated)
+  return std::is_constant_evaluated();
+#else
+  return false;
+#endif
+}
+
+template<typename ValueType>
+struct UseMoveMinimizingBlockExchange
+    : std::integral_constant<bool, !std::is_trivially_copyable<ValueType>::value> {
+};
+
+template<typename Iterator>
+struct IsMoveMinimizingBlockExchangeUsed
+    : std::integral_constant<bool,
+        std::is_base_of<std::random_access_iterator_tag,
+          typename std::iterator_traits<Iterator>::iterator_category>::value
+     && UseMoveMinimizingBlockExchange<
+          typename std::iterator_traits<Iterator>::value_type>::value> {
+};
+
+//Rotates [start, one_past_end) so that middle becomes the first element and
+// returns the new location of *start (like std::rotate()).
+//Each of the gcd(N, K) cycles of the rotation, where N = length of the range
+// and K = std::distance(start, middle), is traversed by holding its first
+// element and then repeatedly moving the element that belongs in the hole
+// into it, so that N + gcd(N, K) moves are performed in total.
+template<typename RandomAccessIterator>
+MWOB_CONSTEXPR20
+inline RandomAccessIterator RotateByCycles_RAI(RandomAccessIterator start,
+                                            RandomAccessIterator middle,
+                                            RandomAccessIterator one_past_end) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::difference_type
+                                                                      Distance;
+  if (start == middle)
+    return one_past_end;
+  if (middle == one_past_end)
+    return start;
+  const Distance length = one_past_end - start;
+  const Distance shift  = middle - start;
+  const Distance num_cycles = std::gcd(length, shift);
+  for (Distance cycle_start = 0; cycle_start < num_cycles; cycle_start++) {
+    auto held_value = std::move(*(start + cycle_start));
+    Distance hole = cycle_start;
+    while (true) {
+      Distance next = hole + shift;
+      if (next >= length)
+        next -= length;
+      if (next == cycle_start)
+        break ;
+      *(start + hole) = std::move(*(start + next));
+      hole = next;
+    }
+    *(start + hole) = std::move(held_value);
+  }
+  return start + (length - shift);
+}
+
+template<typename Iterator>
+struct IsTiledBlockExchangeUsed
+    : std::integral_constant<bool,
+        std::is_pointer<Iterator>::value
+     && std::is_trivially_copyable<
+          typename std::iterator_traits<Iterator>::value_type>::value
+     && !IsMoveMinimizingBlockExchangeUsed<Iterator>::value> {
+};
+
+//Swaps the num_bytes bytes at block1 with those at block2.
+//If is_non_temporal is true then block1 and block2 must have the same
+// alignment modulo 16.
+inline void SwapBytes(unsigned char *block1, unsigned char *block2,
+                      std::size_t num_bytes, bool is_non_temporal) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  if (is_non_temporal) {
+    for ( ; i < num_bytes
+           && (reinterpret_cast<std::uintptr_t>(block1 + i) % 16) != 0; i++)
+      std::swap(block1[i], block2[i]);
+    for ( ; i + 16 <= num_bytes; i += 16) {
+      __m128i value1 = _mm_load_si128(reinterpret_cast<__m128i *>(block1 + i));
+      __m128i value2 = _mm_load_si128(reinterpret_cast<__m128i *>(block2 + i));
+      _mm_stream_si128(reinterpret_cast<__m128i *>(block1 + i), value2);
+      _mm_stream_si128(reinterpret_cast<__m128i *>(block2 + i), value1);
+    }
+  } else {
+    for ( ; i + 16 <= num_bytes; i += 16) {
+      __m128i value1 = _mm_loadu_si128(reinterpret_cast<__m128i *>(block1 + i));
+      __m128i value2 = _mm_loadu_si128(reinterpret_cast<__m128i *>(block2 + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(block1 + i), value2);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(block2 + i), value1);
+    }
+  }
+#else
+  (void)is_non_temporal;
+  for ( ; i + sizeof(std::uint64_t) <= num_bytes; i += sizeof(std::uint64_t)) {
+    std::uint64_t value1, value2;
+    std::memcpy(&value1, block1 + i, sizeof(std::uint64_t));
+    std::memcpy(&value2, block2 + i, sizeof(std::uint64_t));
+    std::memcpy(block1 + i, &value2, sizeof(std::uint64_t));
+    std::memcpy(block2 + i, &value1, sizeof(std::uint64_t));
+  }
+#endif
+  for ( ; i < num_bytes; i++)
+    std::swap(block1[i], block2[i]);
+  return ;
+}
+
+//Exchanges the (non-overlapping) blocks [start1, one_past_end1) and
+// [start2, start2 + (one_past_end1 - start1)) of trivially copyable values
+// one tile at a time.
+template<typename T>
+inline void SwapBlocksTiled_ptr(T *start1, T *one_past_end1, T *start2) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SwapBlocksTiled_ptr() swaps the values' bytes.");
+  unsigned char *block1 = reinterpret_cast<unsigned char *>(start1);
+  unsigned char *block2 = reinterpret_cast<unsigned char *>(start2);
+  const std::size_t num_bytes = static_cast<std::size_t>(one_past_end1 - start1)
+                                * sizeof(T);
+  const std::size_t tile_bytes = MWOB_SWAP_TILE_BYTES > 0 ?
+                                 MWOB_SWAP_TILE_BYTES : 16384;
+  const bool is_larger_than_cache = num_bytes > MWOB_LLC_SIZE_BYTES;
+  bool is_non_temporal = false;
+#if defined(__SSE2__)
+  is_non_temporal = MWOB_USE_NON_TEMPORAL_STORES && is_larger_than_cache
+      && (reinterpret_cast<std::uintptr_t>(block1) % 16)
+          == (reinterpret_cast<std::uintptr_t>(block2) % 16);
+#endif
+  for (std::size_t offset = 0; offset < num_bytes; offset += tile_bytes) {
+    std::size_t length = std::min(tile_bytes, num_bytes - offset);
+#if defined(__GNUC__)
+    if (is_larger_than_cache) {
+      std::size_t next_offset = offset + length;
+      std::size_t next_end    = std::min(num_bytes, next_offset + tile_bytes);
+      for (std::size_t i = next_offset; i < next_end; i += 64) {
+        __builtin_prefetch(block1 + i, 1);
+        __builtin_prefetch(block2 + i, 1);
+      }
+    }
+#endif
+    SwapBytes(block1 + offset, block2 + offset, length, is_non_temporal);
+  }
+#if defined(__SSE2__)
+  if (is_non_temporal)
+    _mm_sfence();
+#endif
+  return ;
+}
+
+//Exchanges the equally long blocks [start1, one_past_end1) and
+// [start2, start2 + std::distance(start1, one_past_end1)).
+//Every cycle of this permutation has length 2 so swapping pairs of elements
+// already uses the fewest possible moves.
+template<typename Iterator>
+MWOB_CONSTEXPR20
+inline void SwapBlocks(Iterator start1, Iterator one_past_end1,
+                       Iterator start2) {
+  if constexpr (IsTiledBlockExchangeUsed<Iterator>::value) {
+    typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+    if (!IsConstantEvaluated() &&
+        static_cast<std::size_t>(one_past_end1 - start1) * sizeof(ValueType)
+                                                  >= MWOB_TILED_SWAP_MIN_BYTES) {
+      SwapBlocksTiled_ptr(start1, one_past_end1, start2);
+      return ;
+    }
+  }
+  std::swap_ranges(start1, one_past_end1, start2);
+  return ;
+}
+
+//Rotates [start, one_past_end) by copying the shorter of the two blocks
+// into an array on the stack, moving the longer block by std::memmove() into
+// its final place, and copying the shorter block back, so that every element
+// of the longer block is moved exactly once.
+//Assumes that: min(middle - start, one_past_end - middle) * sizeof(T)
+//                <= MWOB_ROTATE_STACK_BYTES
+template<typename T>
+inline void RotateThroughStackArray_ptr(T *start, T *middle, T *one_past_end) {
+  alignas(T) unsigned char stack_array[MWOB_ROTATE_STACK_BYTES > 0 ?
+                                       MWOB_ROTATE_STACK_BYTES : 1];
+  std::size_t num_bytes_left  = (middle - start) * sizeof(T);
+  std::size_t num_bytes_right = (one_past_end - middle) * sizeof(T);
+  if (num_bytes_left <= num_bytes_right) {
+    std::memcpy(stack_array, start, num_bytes_left);
+    std::memmove(start, middle, num_bytes_right);
+    std::memcpy(start + (one_past_end - middle), stack_array, num_bytes_left);
+  } else {
+    std::memcpy(stack_array, middle, num_bytes_right);
+    std::memmove(one_past_end - (middle - start), start, num_bytes_left);
+    std::memcpy(start, stack_array, num_bytes_right);
+  }
+  return ;
+}
+
+//Rotates [start, one_past_end) by the Gries-Mills block swap algorithm:
+// the shorter of the two blocks is swapped into its final place, which
+// leaves a smaller rotation of the same kind to be performed. Once the
+// shorter block fits in MWOB_ROTATE_STACK_BYTES bytes the rest of the
+// rotation is performed by RotateThroughStackArray_ptr() (or, if that is
+// disabled, once it is smaller than MWOB_TILED_SWAP_MIN_BYTES by
+// std::rotate()).
+//Returns the new location of *start (like std::rotate()).
+template<typename T>
+inline T *RotateBlocksTiled_ptr(T *start, T *middle, T *one_past_end) {
+  T *new_start_location = start + (one_past_end - middle);
+  while (start != middle && middle != one_past_end) {
+    std::ptrdiff_t length_left  = middle - start;
+    std::ptrdiff_t length_right = one_past_end - middle;
+    std::size_t num_bytes_shorter =
+           static_cast<std::size_t>(std::min(length_left, length_right))
+                                                                  * sizeof(T);
+    if (num_bytes_shorter <= MWOB_ROTATE_STACK_BYTES) {
+      RotateThroughStackArray_ptr(start, middle, one_past_end);
+      break ;
+    }
+    if (num_bytes_shorter < MWOB_TILED_SWAP_MIN_BYTES) {
+      std::rotate(start, middle, one_past_end);
+      break ;
+    }
+    if (length_left <= length_right) {
+      SwapBlocksTiled_ptr(start, middle, middle);
+      start   = middle;
+      middle += length_left;
+    } else {
+      SwapBlocksTiled_ptr(middle - length_right, middle, middle);
+      one_past_end = middle;
+      middle      -= length_right;
+    }
+  }
+  return new_start_location;
+}
+
+//Equivalent to std::rotate(start, middle, one_past_end).
+template<typename Iterator>
+MWOB_CONSTEXPR20
+inline Iterator RotateBlocks(Iterator start, Iterator middle,
+                             Iterator one_past_end) {
+  if constexpr (IsMoveMinimizingBlockExchangeUsed<Iterator>::value) {
+    return RotateByCycles_RAI(start, middle, one_past_end);
+  } else if constexpr (IsTiledBlockExchangeUsed<Iterator>::value) {
+    if (!IsConstantEvaluated())
+      return RotateBlocksTiled_ptr(start, middle, one_past_end);
+  }
+  return std::rotate(start, middle, one_past_end);
+}
+
+//Let L = [start_left, start_right), which has length length_left, and let
+// R_1, R_2, ... be the consecutive blocks of length length_left that follow
+// it. This function moves L past R_1, R_2, ..., R_k where k is the largest
+// integer such that k * length_left < length_right (i.e. such that L is
+// shorter than what remains of the right list after L is moved past R_{k-1})
+// and such that *start_left is greater than the last element of each of
+// R_2, ..., R_k (the caller has already checked this for R_1).
+//This is the same as swapping L with R_1, then with R_2, and so on, which is
+// exactly what is done if neither move minimizing nor tiled block exchange
+// is used. Otherwise k is found first and L is then moved past all k blocks
+// by a single RotateBlocks().
+//Returns the new location of *start_left and subtracts k * length_left from
+// length_right.
+//Assumes that:
+// (1) length_left < length_right
+// (2) comp(*(start_right + (length_left - 1)), *start_left)
+template<typename RandomAccessIterator, typename Compare, typename Distance>
+MWOB_CONSTEXPR20
+inline RandomAccessIterator MoveLeftBlockPastSmallerBlocks_RAI(
+                                          RandomAccessIterator start_left,
+                                          RandomAccessIterator start_right,
+                                          Distance length_left,
+                                          Distance &length_right,
+                                          Compare comp) {
+  if constexpr (!IsMoveMinimizingBlockExchangeUsed<
+                                               RandomAccessIterator>::value &&
+                !IsTiledBlockExchangeUsed<RandomAccessIterator>::value) {
+    do {
+      SwapBlocks(start_left, start_right, start_right);
+      start_left    = start_right;
+      start_right  += length_left;
+      length_right -= length_left;
+    } while (length_left < length_right
+          && comp(*(start_right + (length_left - 1)), *start_left));
+    return start_left;
+  } else {
+    //L is not moved until the very end so *start_left is still L's first
+    // element and each R_i is still at its original location.
+    RandomAccessIterator one_past_end_blocks = start_right + length_left;
+    length_right -= length_left;
+    while (length_left < length_right
+        && comp(*(one_past_end_blocks + (length_left - 1)), *start_left)) {
+      one_past_end_blocks += length_left;
+      length_right        -= length_left;
+    }
+    return RotateBlocks(start_left, start_right, one_past_end_blocks);
+  }
+}
+
+//This is the mirror image of MoveLeftBlockPastSmallerBlocks_RAI(): the right
+// list R = [start_right, one_past_end), which has length length_right, is
+// moved leftwards past the consecutive blocks of length length_right that
+// precede it for as long as R is shorter than what remains of the left list
+// and the last element of R is less than the first element of the next block.
+//Returns the new location of *start_right and subtracts
+// (number of blocks moved past) * length_right from length_left.
+//Assumes that:
+// (1) length_right < length_left
+// (2) comp(*(one_past_end - 1), *(start_right - length_right))
+template<typename RandomAccessIterator, typename Compare, typename Distance>
+MWOB_CONSTEXPR20
+inline RandomAccessIterator MoveRightBlockPastSmallerBlocks_RAI(
+                                          RandomAccessIterator start_right,
+                                          RandomAccessIterator one_past_end,
+                                          Distance &length_left,
+                                          Distance length_right,
+                                          Compare comp) {
+  if constexpr (!IsMoveMinimizingBlockExchangeUsed<
+                                               RandomAccessIterator>::value &&
+                !IsTiledBlockExchangeUsed<RandomAccessIterator>::value) {
+    do {
+      SwapBlocks(start_right, one_past_end, start_right - length_right);
+      one_past_end  = start_right;
+      start_right  -= length_right;
+      length_left  -= length_right;
+    } while (length_left > length_right
+          && comp(*(one_past_end - 1), *(start_right - length_right)));
+    return start_right;
+  } else {
+    RandomAccessIterator end_right = one_past_end - 1;
+    RandomAccessIterator start_blocks = start_right - length_right;
+    length_left -= length_right;
+    while (length_left > length_right
+        && comp(*end_right, *(start_blocks - length_right))) {
+      start_blocks -= length_right;
+      length_left  -= length_right;
+    }
+    RotateBlocks(start_blocks, start_right, one_past_end);
+    return start_blocks;
+  }
+}
+
+} //END namespace: mwob_namespace
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_BLOCK_EXCHANGE_H_ */
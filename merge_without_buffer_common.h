@@ -11,10 +11,22 @@
 
 
 #include <algorithm>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#include "merge_without_buffer_block_exchange.h"
+#include "merge_without_buffer_networks.h"
 
 #ifndef IDENTITY_MACRO
 //#define IDENTITY_MACRO(a) a
@@ -24,6 +36,27 @@
 #define ASSERT(a) IDENTITY_MACRO(assert(a))
 #endif
 
+//If m * m * MWOB_UNBALANCED_MERGE_RATIO <= n, where m (resp. n) is the length
+// of the shorter (resp. longer) list, then the RAI implementations hand the
+// merge to mwob_namespace::MergeUnbalanced_RAI().
+#ifndef MWOB_UNBALANCED_MERGE_RATIO
+#define MWOB_UNBALANCED_MERGE_RATIO 4
+#endif
+
+//The recursive merges hand their remaining subproblems to
+// mwob_namespace::MergeByRotations() once the recursion depth exceeds
+// MWOB_WATCHDOG_DEPTH_FACTOR * (log2(N) + 1) or once the subproblem size
+// budget used so far exceeds MWOB_WATCHDOG_BUDGET_FACTOR * N * (log2(N) + 1),
+// where N is the length of the merged range. See mwob_namespace::MergeWatchdog.
+//The recursion is naturally deep (although the work is small) when one list
+// is much shorter than the other, hence the large depth factor.
+#ifndef MWOB_WATCHDOG_DEPTH_FACTOR
+#define MWOB_WATCHDOG_DEPTH_FACTOR 64
+#endif
+#ifndef MWOB_WATCHDOG_BUDGET_FACTOR
+#define MWOB_WATCHDOG_BUDGET_FACTOR 4
+#endif
+
 
 template<typename RandomAccessIterator>
 inline void AdvanceBackward(RandomAccessIterator &it, std::size_t n,
@@ -77,6 +110,7 @@ namespace mwob_namespace {
 //      while start+1 becomes the first value in the range.
 //
 template<typename ForwardIterator, typename Distance>
+MWOB_CONSTEXPR20
 inline void RotateLeftBy1(ForwardIterator start,
                           ForwardIterator one_past_end) {
   auto it_one_ahead = start;
@@ -100,6 +134,7 @@ inline void RotateLeftBy1(ForwardIterator start,
 // (1) std::distance(start, end) >= 1
 //
 template<typename BidirectionalIterator, typename Distance>
+MWOB_CONSTEXPR20
 inline void RotateRightBy1(BidirectionalIterator start,
                            BidirectionalIterator end) {
   auto it_one_behind = end;
@@ -119,6 +154,7 @@ inline void RotateRightBy1(BidirectionalIterator start,
 // (1) std::distance(start, end) >= 1
 // (2) length_minus1 == std::distance(start, end)
 template<typename BidirectionalIterator, typename Distance>
+MWOB_CONSTEXPR20
 inline void RotateRightBy1(BidirectionalIterator start,
                            BidirectionalIterator end,
                            Distance length_minus1) {
@@ -151,6 +187,7 @@ ASSERT(it_one_behind == start);
 //
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline RandomAccessIterator LargestIteratorLessThan_KnownToExist_RAI(
                         RandomAccessIterator start_it,
                         RandomAccessIterator end_it,
@@ -363,6 +400,7 @@ ASSERT(length == std::distance(start_it, end_right) + 1);
 //  linear search starting from the end_it.
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline RandomAccessIterator SmallestIteratorGreaterThan_KnownToExist_RAI(
             RandomAccessIterator start_it,
             RandomAccessIterator end_it,
@@ -544,6 +582,7 @@ ASSERT(std::distance(start_it, end_it) == cur_length_minus_one);
 //  std::distance(iter, end_left) + 1
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline void TrimLeft1_RAI(RandomAccessIterator &start_left_out,
                   RandomAccessIterator end_left,
                   ValueType &start_right_value,
@@ -629,6 +668,7 @@ ASSERT(length_left_out >= 1);
 //  std::distance(start_right, iter + 1)
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline void TrimRight1_RAI(ValueType &end_left_value,
                            RandomAccessIterator start_right,
                            RandomAccessIterator &end_right_out,
@@ -718,16 +758,19 @@ ASSERT(comp(*end_right_out, *end_left));
  * NOTES:
  *  (1) If *end_left > *(end_left + 1) and such a d exists then d is
  *       necessarily > 0.
+ *  (2) Only *(end_left - d) and *(start_right + d) for 0 <= d < length - 1
+ *       are read so the two ranges need not be adjacent (CoRank() relies on
+ *       this).
  */
 template<typename RandomAccessIterator, typename Compare,
          typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
 inline Distance DisplacementToPotentialMedians_KnownToExist_RAI(
                                             RandomAccessIterator end_left,
                                             RandomAccessIterator start_right,
                                             Distance length,
                                             Compare comp,
                                             CompareLessOrEqual comp_le) {
-ASSERT(start_right == end_left + 1);
   (void)--length;       //We will now use length as if it were d_upper.
   Distance d_lower = 0; //So that end_left - d_lower = end_left
   do {
@@ -742,6 +785,306 @@ ASSERT(start_right == end_left + 1);
 }
 
 
+
+//Returns true if MergeUnbalanced_RAI() should be used to merge two lists of
+// the given lengths, i.e. if m * m * MWOB_UNBALANCED_MERGE_RATIO <= n where
+// m (resp. n) is the length of the shorter (resp. longer) list.
+template<typename Distance>
+MWOB_CONSTEXPR20
+inline bool IsUnbalancedMergePreferable(Distance length_left,
+                                        Distance length_right) {
+  Distance length_short = length_left < length_right ? length_left
+                                                     : length_right;
+  Distance length_long  = length_left < length_right ? length_right
+                                                     : length_left;
+  return length_short <= length_long / length_short
+                                    / static_cast<Distance>(
+                                                  MWOB_UNBALANCED_MERGE_RATIO);
+}
+
+/* Merges [start_left, start_right) and [start_right, one_past_end), where
+ *  the shorter list is assumed to be MUCH shorter than the longer list (e.g.
+ *  a small sorted batch that was appended to the end of a huge sorted range).
+ * Let m (resp. n) be the length of the shorter (resp. longer) list.
+ * The elements of the shorter list are placed by Hwang-Lin style block
+ *  insertion: the position in the long list of the outermost element of the
+ *  short list (i.e. its last element if it is the right list and its first
+ *  element otherwise) is found by galloping, with a step of about n / m,
+ *  from the end of the long list that is nearest to (i.e. adjacent to) the
+ *  short list away from the short list, followed by a binary search. The
+ *  block of the long list that lies between this position and the short
+ *  list is then moved past the short list (to its final location) by a
+ *  single rotation.
+ * This uses about m * log2(n / m) comparisons and moves each element of the
+ *  long list at most once, but the short list may be moved up to m times, so
+ *  this should only be called if m * m is small compared to n (see
+ *  IsUnbalancedMergePreferable()).
+ * Assumes that: length_left  == std::distance(start_left,  start_right) and
+ *               length_right == std::distance(start_right, one_past_end).
+ */
+template<typename RandomAccessIterator, typename Compare,
+         typename Distance, typename CompareLessOrEqual, typename ValueType>
+MWOB_CONSTEXPR20
+inline void MergeUnbalanced_RAI(RandomAccessIterator start_left,
+                                RandomAccessIterator start_right,
+                                RandomAccessIterator one_past_end,
+                                Distance length_left,
+                                Distance length_right,
+                                Compare comp,
+                                CompareLessOrEqual comp_le) {
+  while (length_left > 0 && length_right > 0 &&
+         !comp_le(*(start_right - 1), *start_right)) {
+    if (length_right <= length_left) {
+      //Insert the short right list's elements from its back.
+      auto &value = *(one_past_end - 1);
+      Distance step = length_left / length_right;
+      auto it = start_right; //All of [it, start_right) are > value.
+      while (it - start_left > step && comp(value, *(it - step)))
+        it -= step;
+      auto lower = it - start_left > step ? it - step : start_left;
+      auto position = std::upper_bound(lower, it, value, comp);
+      Distance length_moved = start_right - position;
+      if (length_moved > 0) {
+        RotateBlocks(position, start_right, one_past_end);
+        start_right   = position;
+        one_past_end -= length_moved;
+        length_left  -= length_moved;
+        if (length_left <= 0)
+          return ;
+      }
+      //Elements at the back of the right list that are >= the left list's
+      // last element are now in their final positions.
+      auto &end_left_value = *(start_right - 1);
+      do {
+        (void)--one_past_end;
+        (void)--length_right;
+      } while (length_right > 0 && comp_le(end_left_value, *(one_past_end - 1)));
+    } else {
+      //Insert the short left list's elements from its front.
+      auto &value = *start_left;
+      Distance step = length_right / length_left;
+      auto it = start_right; //All of [start_right, it) are < value.
+      while (one_past_end - it > step && comp(*(it + (step - 1)), value))
+        it += step;
+      auto upper = one_past_end - it > step ? it + step : one_past_end;
+      auto position = std::lower_bound(it, upper, value, comp);
+      Distance length_moved = position - start_right;
+      if (length_moved > 0) {
+        RotateBlocks(start_left, start_right, position);
+        start_left   += length_moved;
+        start_right   = position;
+        length_right -= length_moved;
+        if (length_right <= 0)
+          return ;
+      }
+      //Elements at the front of the left list that are <= the right list's
+      // first element are now in their final positions.
+      auto &start_right_value = *start_right;
+      do {
+        (void)++start_left;
+        (void)--length_left;
+      } while (length_left > 0 && comp_le(*start_left, start_right_value));
+    }
+  }
+  return ;
+}
+
+/* IsContiguousIterator<Iterator>::value is true if Iterator is known to
+ *  iterate over objects that are stored contiguously in memory, which is the
+ *  case for raw pointers (and so also C arrays and, in practice,
+ *  std::array<T, N>::iterator) and std::vector<T>::iterator (T != bool).
+ * For such iterators, the MergeWithOutBuffer*() dispatch functions call the
+ *  random access iterator implementations with raw pointers rather than with
+ *  Iterator, which gives the compiler code that it can more easily optimize.
+ * Under C++20 this is std::contiguous_iterator<Iterator>.
+ */
+#if defined(__cpp_lib_concepts)
+template<typename Iterator>
+struct IsContiguousIterator
+    : std::integral_constant<bool, std::contiguous_iterator<Iterator>> {};
+#else
+template<typename Iterator, typename = void>
+struct IsContiguousIterator : std::false_type {};
+
+template<typename ValueType>
+struct IsContiguousIterator<ValueType *, void> : std::true_type {};
+
+template<typename Iterator>
+struct IsContiguousIterator<Iterator, typename std::enable_if<
+          !std::is_pointer<Iterator>::value && !std::is_same<bool,
+                  typename std::iterator_traits<Iterator>::value_type>::value
+       >::type>
+    : std::integral_constant<bool, std::is_same<Iterator,
+          typename std::vector<typename std::iterator_traits<Iterator
+                                                   >::value_type>::iterator
+                                                >::value> {};
+#endif
+
+//Returns a pointer to the object that it points to.
+//Assumes that: it is dereferenceable and IsContiguousIterator<Iterator>.
+template<typename Iterator>
+MWOB_CONSTEXPR20
+inline auto IteratorToPointer(Iterator it) -> decltype(std::addressof(*it)) {
+  return std::addressof(*it);
+}
+
+//The complement C(x, y) := !comp(y, x) of comp, i.e. "less than or equal
+// to", which the dispatch functions pass to the recursions as comp_le.
+//Unlike a lambda, its copy of comp can be replaced (see
+// RaiseSharedPrefixLength_RAI()).
+template<typename Compare>
+struct ComplementCompare {
+  MWOB_CONSTEXPR20 explicit ComplementCompare(Compare comp_in)
+      : comp(comp_in) {
+  }
+
+  template<typename ValueType>
+  MWOB_CONSTEXPR20 bool operator()(const ValueType &lhs,
+                                   const ValueType &rhs) const {
+    return !comp(rhs, lhs);
+  }
+
+  Compare comp;
+};
+
+//Subproblems with fewer elements than this do not raise their comparison
+// object's shared prefix length (see RaiseSharedPrefixLength_RAI()).
+#ifndef MWOB_SHARED_PREFIX_MIN_LENGTH
+#define MWOB_SHARED_PREFIX_MIN_LENGTH 64
+#endif
+
+//IsSharedPrefixCompare<Compare, ValueType>::value is true if comp can be told
+// that all of the values that it will compare from now on lie between two
+// given values, i.e. if it has a member function
+// RaiseSharedPrefixLength(min_value, max_value) (see SharedPrefixLess in
+// merge_without_buffer_strings.h).
+template<typename Compare, typename ValueType, typename = void>
+struct IsSharedPrefixCompare : std::false_type {};
+
+template<typename Compare, typename ValueType>
+struct IsSharedPrefixCompare<Compare, ValueType, std::void_t<decltype(
+          std::declval<Compare &>().RaiseSharedPrefixLength(
+              std::declval<const ValueType &>(),
+              std::declval<const ValueType &>()))>>
+    : std::true_type {};
+
+//Called by the _RAI recursions once a subproblem has been trimmed, at which
+// point *start_right is the subproblem's least value and *end_left, where
+// end_left == start_right - 1, is its greatest value (see the end of
+// Trim1_switch_RAI()). So comp (and, if it is a ComplementCompare, comp_le)
+// may skip the prefix that these two values share in all of the
+// subproblem's comparisons and in those of its subproblems, which are passed
+// these copies.
+template<typename RandomAccessIterator, typename Compare,
+         typename CompareLessOrEqual>
+MWOB_CONSTEXPR20
+inline void RaiseSharedPrefixLength_RAI(RandomAccessIterator start_right,
+                                        Compare &comp,
+                                        CompareLessOrEqual &comp_le) {
+  comp.RaiseSharedPrefixLength(*start_right, *(start_right - 1));
+  if constexpr (std::is_same<CompareLessOrEqual,
+                             ComplementCompare<Compare>>::value)
+    comp_le.comp = comp;
+  return ;
+}
+
+//Bounds the recursion depth of a recursive merge and the sum of the sizes of
+// its subproblems, like introsort's depth limit: once either bound is
+// exceeded the watchdog trips and every subproblem that is subsequently
+// started is merged by MergeByRotations() instead, whose worst case is
+// O(N log(N)).
+//The subproblem size budget is charged, when each subproblem is started, the
+// length of the shorter of its two (untrimmed) lists. This is NOT a count of
+// the elements that are actually moved (the moves performed by the trims, by
+// MergeUnbalanced_RAI(), and by the swaps are not counted); it is a proxy that
+// bounds the size of the blocks that a subproblem's swaps can exchange (the
+// longer list is mostly trimmed by binary searches) and that is cheap to
+// maintain. On random inputs the budget used is less than
+// N * (log2(N) + 1) / 2.
+struct MergeWatchdog {
+  MWOB_CONSTEXPR20 explicit MergeWatchdog(std::uintmax_t length) {
+    std::uintmax_t log2_length_plus1 = 1;
+    for (std::uintmax_t i = length; i > 1; i /= 2)
+      log2_length_plus1++;
+    depth_limit_  = MWOB_WATCHDOG_DEPTH_FACTOR * log2_length_plus1;
+    budget_limit_ = MWOB_WATCHDOG_BUDGET_FACTOR * length * log2_length_plus1;
+  }
+
+  //Records that a subproblem whose shorter list has the given length is
+  // being started at the given recursion depth and returns true if it should
+  // be merged by MergeByRotations().
+  MWOB_CONSTEXPR20 bool ShouldFallBack(std::uintmax_t depth,
+                                       std::uintmax_t length) {
+    if (!has_tripped_) {
+      budget_used_ += length;
+      has_tripped_ = depth > depth_limit_ || budget_used_ > budget_limit_;
+    }
+    return has_tripped_;
+  }
+
+  constexpr bool HasTripped() const { return has_tripped_; }
+  constexpr std::uintmax_t DepthLimit() const { return depth_limit_; }
+  constexpr std::uintmax_t BudgetLimit() const { return budget_limit_; }
+  constexpr std::uintmax_t BudgetUsed() const { return budget_used_; }
+
+private:
+  std::uintmax_t depth_limit_;
+  std::uintmax_t budget_limit_;
+  std::uintmax_t budget_used_ = 0;
+  bool has_tripped_ = false;
+};
+
+//Merges the non-decreasing sequences [start_left, start_right) and
+// [start_right, one_past_end) in the same way as libstdc++'s
+// std::__merge_without_buffer(): the longer sequence is cut in half, the
+// other is cut at the (lower or upper) bound of the cut value, the two middle
+// blocks are rotated, and the two resulting subproblems are merged. Since
+// the longer sequence is halved, each subproblem has at most 3/4 of the
+// elements, so the recursion depth is O(log(N)) and, since each level
+// performs O(N) moves and comparisons, O(N log(N)) are performed in total.
+//The merge is stable. The second subproblem is handled by the loop so that
+// the stack only grows with the first one.
+template<typename BidirectionalIterator, typename Compare, typename Distance>
+MWOB_CONSTEXPR20
+void MergeByRotations(BidirectionalIterator start_left,
+                      BidirectionalIterator start_right,
+                      BidirectionalIterator one_past_end,
+                      Distance length_left,
+                      Distance length_right,
+                      Compare comp) {
+  while (length_left > 0 && length_right > 0) {
+    if (length_left + length_right == 2) {
+      if (comp(*start_right, *start_left))
+        std::iter_swap(start_left, start_right);
+      return ;
+    }
+    BidirectionalIterator cut_left, cut_right;
+    Distance length_cut_left, length_cut_right;
+    if (length_left > length_right) {
+      length_cut_left = length_left / 2;
+      cut_left = start_left;
+      std::advance(cut_left, length_cut_left);
+      cut_right = std::lower_bound(start_right, one_past_end, *cut_left, comp);
+      length_cut_right = std::distance(start_right, cut_right);
+    } else {
+      length_cut_right = length_right / 2;
+      cut_right = start_right;
+      std::advance(cut_right, length_cut_right);
+      cut_left = std::upper_bound(start_left, start_right, *cut_right, comp);
+      length_cut_left = std::distance(start_left, cut_left);
+    }
+    BidirectionalIterator new_middle = RotateBlocks(cut_left, start_right,
+                                                    cut_right);
+    MergeByRotations<BidirectionalIterator, Compare, Distance>(start_left,
+        cut_left, new_middle, length_cut_left, length_cut_right, comp);
+    start_left    = new_middle;
+    start_right   = cut_right;
+    length_left  -= length_cut_left;
+    length_right -= length_cut_right;
+  }
+  return ;
+}
+
 } //END namespace: merge_without_buffer_common_namespace
 
 #ifdef ASSERT
@@ -0,0 +1,181 @@
+/*
+ * merge_without_buffer_corank.h
+ *
+ *  CoRank() answers position queries about the stable merge of two sorted
+ *   ranges without merging them. Given 0 <= k <= length_left + length_right
+ *   it returns the pair (i, j), with i + j == k, such that the first k
+ *   elements of the stable merge of left and right are exactly
+ *   [start_left, start_left + i) and [start_right, start_right + j). Since
+ *   the merge is stable (i.e. left elements precede equivalent right
+ *   elements) (i, j) is unique and it is characterized by:
+ *  (1) i == 0 or j == length_right or *(start_left + (i - 1)) <=
+ *      *(start_right + j), and
+ *  (2) j == 0 or i == length_left or *(start_right + (j - 1)) <
+ *      *(start_left + i).
+ *
+ *  Let i0 = min(k, length_left) and j0 = k - i0. Moving the split by d
+ *   (i.e. i = i0 - d and j = j0 + d) makes (2) hold exactly when (1) fails
+ *   for d - 1, so (i, j) is given by the smallest 0 <= d <= D, where
+ *   D = min(i0, length_right - j0), such that d == D or
+ *   *(start_left + (i0 - 1 - d)) <= *(start_right + (j0 + d)), which is
+ *   exactly what DisplacementToPotentialMedians_KnownToExist_RAI() finds with
+ *   end_left = start_left + (i0 - 1), start_right + j0, and length = D + 1.
+ *   This takes at most ceil(log2(D + 1)) comparisons.
+ *
+ *  ElementOfMergeAt(..., n, ...) returns an iterator to the element that
+ *   would be at position n (0 <= n < length_left + length_right) of the
+ *   stable merge, e.g. a median or a percentile.
+ *
+ *  The iterators must be random access iterators. As with
+ *   MergeWithOutBuffer1(), the three iterator overloads assume that the right
+ *   range immediately follows the left range.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> left({ 1, 2, 4, 4, 9 });
+  std::vector<int> right({ 0, 3, 4, 5, 6, 10 });
+  //The first 6 elements of the merge are 0, 1, 2, 3, 4, 4 of which the two 4s
+  // are left's (left elements precede equivalent right elements).
+  auto split = CoRank(left.begin(), left.end(), right.begin(), right.end(), 6);
+  //split.first == 4 and split.second == 2
+  auto median = ElementOfMergeAt(left.begin(), left.end(),
+                                 right.begin(), right.end(), 5);
+  //median == left.begin() + 3, so the median is 4
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_CORANK_H_
+#define SRC_MERGE_WITHOUT_BUFFER_CORANK_H_
+
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "merge_without_buffer_common.h"
+
+template<typename RandomAccessIterator, typename Compare,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+MWOB_CONSTEXPR20
+inline std::pair<Distance, Distance> CoRank(
+                                     RandomAccessIterator start_left,
+                                     RandomAccessIterator one_past_end_left,
+                                     RandomAccessIterator start_right,
+                                     RandomAccessIterator one_past_end_right,
+                                     Distance k,
+                                     Compare comp) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  auto comp_le = [comp](const ValueType &lhs, const ValueType &rhs) -> bool {
+    return !comp(rhs, lhs);
+  };
+  typedef decltype(comp_le) CompareLessOrEqual;
+  Distance length_left  = one_past_end_left - start_left;
+  Distance length_right = one_past_end_right - start_right;
+  //assert(k >= 0 && k <= length_left + length_right);
+  Distance i0 = k < length_left ? k : length_left;
+  Distance j0 = k - i0;
+  Distance max_displacement = length_right - j0 < i0 ? length_right - j0 : i0;
+  if (max_displacement <= 0)
+    return std::pair<Distance, Distance>(i0, j0);
+  Distance d = mwob_namespace::DisplacementToPotentialMedians_KnownToExist_RAI<
+      RandomAccessIterator, Compare, Distance, CompareLessOrEqual, ValueType>(
+          start_left + (i0 - 1), start_right + j0, max_displacement + 1,
+          comp, comp_le);
+  return std::pair<Distance, Distance>(i0 - d, j0 + d);
+}
+
+template<typename RandomAccessIterator,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+MWOB_CONSTEXPR20
+inline std::pair<Distance, Distance> CoRank(
+                                     RandomAccessIterator start_left,
+                                     RandomAccessIterator one_past_end_left,
+                                     RandomAccessIterator start_right,
+                                     RandomAccessIterator one_past_end_right,
+                                     Distance k) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  return CoRank<RandomAccessIterator, std::less<ValueType>, Distance>(
+             start_left, one_past_end_left, start_right, one_past_end_right,
+             k, std::less<ValueType>());
+}
+
+template<typename RandomAccessIterator, typename Compare,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+MWOB_CONSTEXPR20
+inline std::pair<Distance, Distance> CoRank(
+                                     RandomAccessIterator start_left,
+                                     RandomAccessIterator start_right,
+                                     RandomAccessIterator one_past_end_right,
+                                     Distance k,
+                                     Compare comp) {
+  return CoRank<RandomAccessIterator, Compare, Distance>(start_left,
+             start_right, start_right, one_past_end_right, k, comp);
+}
+
+template<typename RandomAccessIterator,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+MWOB_CONSTEXPR20
+inline std::pair<Distance, Distance> CoRank(
+                                     RandomAccessIterator start_left,
+                                     RandomAccessIterator start_right,
+                                     RandomAccessIterator one_past_end_right,
+                                     Distance k) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  return CoRank<RandomAccessIterator, std::less<ValueType>, Distance>(
+             start_left, start_right, start_right, one_past_end_right, k,
+             std::less<ValueType>());
+}
+
+//Returns an iterator to the element that would be at position n of the
+// stable merge of the two ranges.
+//Assumes that: 0 <= n < length_left + length_right
+template<typename RandomAccessIterator, typename Compare,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+MWOB_CONSTEXPR20
+inline RandomAccessIterator ElementOfMergeAt(
+                                     RandomAccessIterator start_left,
+                                     RandomAccessIterator one_past_end_left,
+                                     RandomAccessIterator start_right,
+                                     RandomAccessIterator one_past_end_right,
+                                     Distance n,
+                                     Compare comp) {
+  std::pair<Distance, Distance> split =
+      CoRank<RandomAccessIterator, Compare, Distance>(start_left,
+          one_past_end_left, start_right, one_past_end_right, n, comp);
+  RandomAccessIterator next_left  = start_left + split.first;
+  RandomAccessIterator next_right = start_right + split.second;
+  if (next_left == one_past_end_left)
+    return next_right;
+  if (next_right == one_past_end_right || !comp(*next_right, *next_left))
+    return next_left;
+  return next_right;
+}
+
+template<typename RandomAccessIterator,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+MWOB_CONSTEXPR20
+inline RandomAccessIterator ElementOfMergeAt(
+                                     RandomAccessIterator start_left,
+                                     RandomAccessIterator one_past_end_left,
+                                     RandomAccessIterator start_right,
+                                     RandomAccessIterator one_past_end_right,
+                                     Distance n) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  return ElementOfMergeAt<RandomAccessIterator, std::less<ValueType>,
+             Distance>(start_left, one_past_end_left, start_right,
+                       one_past_end_right, n, std::less<ValueType>());
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_CORANK_H_ */
@@ -0,0 +1,241 @@
+/*
+ * merge_without_buffer_counting.h
+ *
+ *  MergeWithOutBufferCounting(start_left, start_right, one_past_end,
+ *   key_range, comp) merges the adjacent sorted lists
+ *   [start_left, start_right) and [start_right, one_past_end) of integral
+ *   values that the caller promises lie in the small range
+ *   [key_range.min, key_range.max] (e.g. 8 or 16 bit category codes).
+ *
+ *  When the values are integers compared by std::less or std::greater (see
+ *   mwob_namespace::IsMergeNetworkUsable) two equivalent values are equal,
+ *   so the merged list is determined by how many times each value occurs in
+ *   the two lists and the merge needs no element-wise comparisons:
+ *  (1) Trim: the front of the left list that is <= the first element of the
+ *      right list and the back of the right list that is >= the last element
+ *      of the left list are skipped by binary searches.
+ *  (2) Count: the left list is walked one group of equal values at a time,
+ *      the end of each group being found by galloping (i.e. exponential
+ *      search followed by binary search), and the value and size of each
+ *      group is recorded in a table on the stack.
+ *  (3) Write: the right list is walked in the same way, and the groups of
+ *      both lists are merged by writing each value as many times as it
+ *      occurs (by std::memcpy()s of an already filled prefix when the
+ *      values are stored contiguously). The write position never passes the
+ *      unread part of the right list so nothing is overwritten before it has
+ *      been counted.
+ *  If there are D distinct values then O(D log(N)) comparisons are performed
+ *   and every element between the trims is written exactly once.
+ *
+ *  The hint is used to decide whether the table, which has
+ *   MWOB_COUNTING_MAX_KEYS entries, is certain to be large enough. If it is
+ *   not (or if the left list turns out to have more distinct values than the
+ *   table can hold, e.g. because the hint was wrong), if the values cannot be
+ *   merged by counting, or if the iterators are not random access iterators
+ *   then MergeWithOutBuffer1() is called instead.
+ *
+ *  The overload of MergeWithOutBuffer() (in merge_without_buffer.h) that
+ *   takes an IntegralKeyRange calls this function.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<unsigned char> vec({ 0, 2, 2, 7, 1, 2, 3, 3, 7 });
+  //vec[0, 4) and vec[4, 9) are sorted.
+  MergeWithOutBufferCounting(vec.begin(), vec.begin() + 4, vec.end(),
+                             IntegralKeyRange<unsigned char>{ 0, 15 });
+  //vec is now { 0, 1, 2, 2, 2, 3, 3, 7, 7 }.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_COUNTING_H_
+#define SRC_MERGE_WITHOUT_BUFFER_COUNTING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+#include "merge_without_buffer1.h"
+#include "merge_without_buffer_networks.h"
+
+//The number of entries of the table of (value, count) pairs that
+// MergeWithOutBufferCounting() keeps on the stack.
+#ifndef MWOB_COUNTING_MAX_KEYS
+#define MWOB_COUNTING_MAX_KEYS 1024
+#endif
+
+//A caller supplied hint that every value lies in [min, max].
+template<typename KeyType>
+struct IntegralKeyRange {
+  static_assert(std::is_integral<KeyType>::value,
+                "IntegralKeyRange requires an integral key type.");
+  KeyType min;
+  KeyType max;
+
+  //The number of values in [min, max] or 0 if there are more than
+  // MWOB_COUNTING_MAX_KEYS of them (or if min > max).
+  std::size_t SizeIfSmall() const {
+    if (max < min)
+      return 0;
+    std::uintmax_t max_minus_min = static_cast<std::uintmax_t>(max)
+                                 - static_cast<std::uintmax_t>(min);
+    if (max_minus_min >= static_cast<std::uintmax_t>(MWOB_COUNTING_MAX_KEYS))
+      return 0;
+    return static_cast<std::size_t>(max_minus_min) + 1;
+  }
+};
+
+namespace merge_without_buffer_counting_namespace {
+
+//Returns the end of the group of elements that are equal to *start, i.e.
+// std::upper_bound(start, one_past_end, *start, comp), by galloping forwards
+// from start.
+//Assumes that: start != one_past_end
+template<typename RandomAccessIterator, typename Compare>
+inline RandomAccessIterator GallopToEndOfGroup(RandomAccessIterator start,
+                                             RandomAccessIterator one_past_end,
+                                             Compare comp) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::difference_type
+                                                                      Distance;
+  const auto value = *start;
+  Distance length = one_past_end - start;
+  Distance lower = 1; //All of [start, start + lower) are equal to value.
+  Distance step = 2;
+  while (step <= length && !comp(value, *(start + (step - 1)))) {
+    lower = step;
+    step *= 2;
+  }
+  Distance upper = step <= length ? step - 1 : length;
+  return std::upper_bound(start + lower, start + upper, value, comp);
+}
+
+//Writes count copies of value starting at out and returns out + count, like
+// std::fill_n(), which compilers often do not vectorize (e.g. for short). If
+// Iterator is a pointer then the first few copies are written one at a time
+// and the filled prefix is then repeatedly doubled by std::memcpy().
+template<typename Iterator, typename Distance, typename ValueType>
+inline Iterator FillGroup(Iterator out, Distance count, ValueType value) {
+  if constexpr (std::is_pointer<Iterator>::value) {
+    if (count > 16) {
+      std::fill_n(out, 16, value);
+      Distance num_filled = 16;
+      while (num_filled < count) {
+        Distance length = std::min(num_filled, count - num_filled);
+        std::memcpy(out + num_filled, out, length * sizeof(*out));
+        num_filled += length;
+      }
+      return out + count;
+    }
+  }
+  return std::fill_n(out, count, value);
+}
+
+//Returns false, without having modified anything, if the left list has more
+// than MWOB_COUNTING_MAX_KEYS distinct values.
+template<typename RandomAccessIterator, typename Compare>
+bool MergeByCounting_RAI(RandomAccessIterator start_left,
+                         RandomAccessIterator start_right,
+                         RandomAccessIterator one_past_end,
+                         Compare comp) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  typedef typename std::iterator_traits<RandomAccessIterator>::difference_type
+                                                                      Distance;
+  if (start_left == start_right || start_right == one_past_end ||
+      !comp(*start_right, *(start_right - 1)))
+    return true;
+  //Trim.
+  start_left   = std::upper_bound(start_left, start_right, *start_right, comp);
+  one_past_end = std::lower_bound(start_right, one_past_end,
+                                  *(start_right - 1), comp);
+  //Count the left list's groups.
+  ValueType left_values[MWOB_COUNTING_MAX_KEYS];
+  Distance left_counts[MWOB_COUNTING_MAX_KEYS];
+  std::size_t num_left_groups = 0;
+  for (RandomAccessIterator it = start_left; it != start_right; ) {
+    if (num_left_groups == MWOB_COUNTING_MAX_KEYS)
+      return false;
+    RandomAccessIterator one_past_end_group = GallopToEndOfGroup(it,
+                                                          start_right, comp);
+    left_values[num_left_groups] = *it;
+    left_counts[num_left_groups] = one_past_end_group - it;
+    num_left_groups++;
+    it = one_past_end_group;
+  }
+  //Merge the left list's groups with the right list's groups.
+  RandomAccessIterator out = start_left;
+  std::size_t i = 0;
+  RandomAccessIterator it_right = start_right;
+  while (it_right != one_past_end) {
+    const ValueType value = *it_right;
+    while (i < num_left_groups && !comp(value, left_values[i])) {
+      out = FillGroup(out, left_counts[i], left_values[i]);
+      i++;
+    }
+    RandomAccessIterator one_past_end_group = GallopToEndOfGroup(it_right,
+                                                          one_past_end, comp);
+    out = FillGroup(out, one_past_end_group - it_right, value);
+    it_right = one_past_end_group;
+  }
+  for ( ; i < num_left_groups; i++)
+    out = FillGroup(out, left_counts[i], left_values[i]);
+  return true;
+}
+
+} //END namespace: merge_without_buffer_counting_namespace
+
+template<typename Iterator, typename KeyType, typename Compare>
+inline void MergeWithOutBufferCounting(Iterator start_left,
+                                       Iterator start_right,
+                                       Iterator one_past_end,
+                                       IntegralKeyRange<KeyType> key_range,
+                                       Compare comp) {
+  using merge_without_buffer_counting_namespace::MergeByCounting_RAI;
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+  if constexpr (mwob_namespace::IsMergeNetworkUsable<ValueType,
+                                                     Compare>::value &&
+                std::is_base_of<std::random_access_iterator_tag,
+                  typename std::iterator_traits<Iterator>::iterator_category
+                                                                >::value) {
+    if (key_range.SizeIfSmall() > 0) {
+      bool is_merged;
+      if constexpr (!std::is_pointer<Iterator>::value &&
+                    mwob_namespace::IsContiguousIterator<Iterator>::value) {
+        //Lower contiguous iterators (e.g. std::vector<T>::iterator) to
+        // pointers.
+        if (start_left == start_right || start_right == one_past_end)
+          return ;
+        auto start_left_ptr = mwob_namespace::IteratorToPointer(start_left);
+        is_merged = MergeByCounting_RAI(start_left_ptr,
+                        start_left_ptr + (start_right - start_left),
+                        start_left_ptr + (one_past_end - start_left), comp);
+      } else {
+        is_merged = MergeByCounting_RAI(start_left, start_right,
+                                        one_past_end, comp);
+      }
+      if (is_merged)
+        return ;
+    }
+  }
+  MergeWithOutBuffer1(start_left, start_right, one_past_end, comp);
+  return ;
+}
+
+template<typename Iterator, typename KeyType>
+inline void MergeWithOutBufferCounting(Iterator start_left,
+                                       Iterator start_right,
+                                       Iterator one_past_end,
+                                       IntegralKeyRange<KeyType> key_range) {
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+  MergeWithOutBufferCounting(start_left, start_right, one_past_end,
+                             key_range, std::less<ValueType>());
+  return ;
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_COUNTING_H_ */
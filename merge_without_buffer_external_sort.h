@@ -0,0 +1,352 @@
+/*
+ * merge_without_buffer_external_sort.h
+ *
+ *  ExternalSortWithOutBuffer() stably sorts a file of fixed-width records
+ *   that may be much larger than memory while using a single working array of
+ *   (at most) memory_budget_bytes bytes. No other copy of the data is ever
+ *   held in memory.
+ *
+ *  (1) Run generation: the input file is read in chunks that fill the working
+ *      array, each chunk is sorted by StableSortWithOutBuffer(), and the
+ *      resulting sorted run is appended to a temporary file.
+ *  (2) Merge passes: groups of (at most) fan_in adjacent runs are merged into
+ *      single runs until only one run remains; the last pass writes to the
+ *      output file. Each merge of k runs divides the working array into k
+ *      windows of W records, one per run, and repeats the following until
+ *      all runs are consumed:
+ *      (a) Each run's window is refilled (from the file) up to W records.
+ *      (b) The frontier run is the run, among those that have not been
+ *          completely read, whose last loaded record is the smallest (ties are
+ *          broken by the smallest run index). Let f be that record. Every
+ *          record that is not yet loaded is >= f, so the following records
+ *          can be output now: all of the frontier run's loaded records, the
+ *          loaded records <= f of runs before the frontier run, and the loaded
+ *          records < f of runs after it (this keeps the sort stable). If every
+ *          run has been completely read then all loaded records are output.
+ *      (c) The windows are compacted and the records to be output (which form
+ *          a prefix of each window) are gathered to the front of the working
+ *          array by rotations, merged in place by MergeWithOutBuffer1(), and
+ *          written to the output.
+ *      (d) The remaining records of each run are moved back to the front of
+ *          their run's window.
+ *      Since the frontier run's whole window is output in each round, every
+ *      round outputs at least W records (or finishes the frontier run).
+ *
+ *  If fan_in == 0 then it is chosen so that each window holds at least
+ *   MWOB_EXTERNAL_SORT_MIN_WINDOW_RECORDS records (and fan_in >= 2), which
+ *   minimizes the number of merge passes for the given memory budget.
+ *  Temporary files are created by std::tmpfile().
+ *  Returns 0 on success and -errno on failure (-EINVAL if the input's size is
+ *   not a multiple of sizeof(Record) or if the memory budget is smaller than
+ *   2 records).
+ *  Record must be trivially copyable since its bytes are the file's bytes.
+ *  This file requires a POSIX system (for fseeko()).
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  struct Record { std::uint64_t key; char payload[120]; };
+  auto comp = [](const Record &lhs, const Record &rhs) -> bool {
+    return lhs.key < rhs.key;
+  };
+  std::size_t memory_budget_bytes = std::size_t(1) << 30; //1 GiB
+  int result = ExternalSortWithOutBuffer<Record>("in.dat", "out.dat",
+                                                 memory_budget_bytes, comp);
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_EXTERNAL_SORT_H_
+#define SRC_MERGE_WITHOUT_BUFFER_EXTERNAL_SORT_H_
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "merge_without_buffer1.h"
+#include "merge_without_buffer_sort.h"
+
+#ifndef MWOB_EXTERNAL_SORT_MIN_WINDOW_RECORDS
+#define MWOB_EXTERNAL_SORT_MIN_WINDOW_RECORDS 4096
+#endif
+
+namespace merge_without_buffer_external_sort_namespace {
+
+//A sorted run that is stored in a file, measured in records.
+struct RunInfo {
+  std::uint64_t offset;
+  std::uint64_t length;
+};
+
+template<typename Record>
+inline int ReadRecords(std::FILE *file, std::uint64_t offset, Record *records,
+                       std::size_t num_records) {
+  if (num_records == 0)
+    return 0;
+  off_t byte_offset = static_cast<off_t>(offset * sizeof(Record));
+  if (fseeko(file, byte_offset, SEEK_SET) != 0)
+    return -errno;
+  if (std::fread(records, sizeof(Record), num_records, file) != num_records)
+    return std::ferror(file) ? -EIO : -EINVAL;
+  return 0;
+}
+
+template<typename Record>
+inline int WriteRecords(std::FILE *file, const Record *records,
+                        std::size_t num_records) {
+  if (num_records == 0)
+    return 0;
+  if (std::fwrite(records, sizeof(Record), num_records, file) != num_records)
+    return -EIO;
+  return 0;
+}
+
+//Merges the adjacent sorted segments [start, start + lengths[0]),
+// [start + lengths[0], start + lengths[0] + lengths[1]), ... in place by
+// merging neighbouring pairs of segments, bottom-up.
+//lengths is used as scratch space.
+template<typename Record, typename Compare>
+inline void MergeAdjacentSegments(Record *start,
+                                  std::vector<std::ptrdiff_t> &lengths,
+                                  Compare comp) {
+  while (lengths.size() > 1) {
+    Record *segment_start = start;
+    std::size_t num_merged = 0;
+    for (std::size_t i = 0; i < lengths.size(); i += 2) {
+      std::ptrdiff_t length_left  = lengths[i];
+      std::ptrdiff_t length_right = i + 1 < lengths.size() ? lengths[i + 1]
+                                                            : 0;
+      MergeWithOutBuffer1<Record *, Compare, std::ptrdiff_t>(segment_start,
+          segment_start + length_left,
+          segment_start + length_left + length_right,
+          length_left, length_right, comp);
+      segment_start += length_left + length_right;
+      lengths[num_merged++] = length_left + length_right;
+    }
+    lengths.resize(num_merged);
+  }
+  return ;
+}
+
+//Merges runs[0], ..., runs[num_runs - 1], which are stored in in_file, and
+// appends the result to out_file, as described at the top of this file.
+template<typename Record, typename Compare>
+inline int MergeRuns(std::FILE *in_file, const RunInfo *runs,
+                     std::size_t num_runs, std::FILE *out_file,
+                     Record *buffer, std::size_t buffer_length,
+                     Compare comp) {
+  const std::size_t window_length = buffer_length / num_runs;
+  std::vector<std::uint64_t> num_loaded(num_runs, 0);
+  std::vector<std::size_t> length(num_runs, 0);
+  std::vector<std::size_t> num_to_output(num_runs, 0);
+  std::vector<std::ptrdiff_t> segment_lengths;
+  while (true) {
+    //(a) Refill the windows.
+    bool is_any_loaded = false;
+    for (std::size_t i = 0; i < num_runs; i++) {
+      Record *window = buffer + i * window_length;
+      std::size_t num_to_read = static_cast<std::size_t>(
+                                  std::min<std::uint64_t>(
+                                      window_length - length[i],
+                                      runs[i].length - num_loaded[i]));
+      int result = ReadRecords(in_file, runs[i].offset + num_loaded[i],
+                               window + length[i], num_to_read);
+      if (result != 0)
+        return result;
+      length[i]     += num_to_read;
+      num_loaded[i] += num_to_read;
+      is_any_loaded = is_any_loaded || length[i] > 0;
+    }
+    if (!is_any_loaded)
+      return 0;
+    //(b) Find the frontier run and how much of each window can be output.
+    std::size_t frontier = num_runs;
+    for (std::size_t i = 0; i < num_runs; i++) {
+      if (num_loaded[i] == runs[i].length)
+        continue ; //This run has been completely read.
+      if (frontier == num_runs ||
+          comp(buffer[i * window_length + length[i] - 1],
+               buffer[frontier * window_length + length[frontier] - 1]))
+        frontier = i;
+    }
+    std::size_t total_to_output = 0;
+    for (std::size_t i = 0; i < num_runs; i++) {
+      Record *window = buffer + i * window_length;
+      if (frontier == num_runs || i == frontier) {
+        num_to_output[i] = length[i];
+      } else {
+        const Record &frontier_record =
+                    buffer[frontier * window_length + length[frontier] - 1];
+        Record *one_past_output = i < frontier ?
+            std::upper_bound(window, window + length[i], frontier_record, comp):
+            std::lower_bound(window, window + length[i], frontier_record, comp);
+        num_to_output[i] = static_cast<std::size_t>(one_past_output - window);
+      }
+      total_to_output += num_to_output[i];
+    }
+    //(c) Compact the windows, gather the records to be output, merge them, and
+    // write them.
+    {
+      Record *destination = buffer;
+      for (std::size_t i = 0; i < num_runs; i++) {
+        Record *window = buffer + i * window_length;
+        if (destination != window)
+          std::move(window, window + length[i], destination);
+        destination += length[i];
+      }
+      Record *one_past_gathered = buffer + num_to_output[0];
+      Record *contents          = buffer + length[0];
+      for (std::size_t i = 1; i < num_runs; i++) {
+        std::rotate(one_past_gathered, contents, contents + num_to_output[i]);
+        one_past_gathered += num_to_output[i];
+        contents          += length[i];
+      }
+    }
+    segment_lengths.assign(num_to_output.begin(), num_to_output.end());
+    MergeAdjacentSegments(buffer, segment_lengths, comp);
+    int result = WriteRecords(out_file, buffer, total_to_output);
+    if (result != 0)
+      return result;
+    //(d) Move the remaining records back to their windows.
+    std::size_t total_remaining = 0;
+    for (std::size_t i = 0; i < num_runs; i++)
+      total_remaining += length[i] - num_to_output[i];
+    std::move(buffer + total_to_output,
+              buffer + total_to_output + total_remaining, buffer);
+    Record *one_past_remaining = buffer + total_remaining;
+    for (std::size_t i = num_runs; i-- > 0; ) {
+      std::size_t num_remaining = length[i] - num_to_output[i];
+      Record *source = one_past_remaining - num_remaining;
+      Record *window = buffer + i * window_length;
+      //assert(source <= window);
+      std::move_backward(source, one_past_remaining, window + num_remaining);
+      one_past_remaining = source;
+      length[i] = num_remaining;
+    }
+  }
+}
+
+} //END namespace: merge_without_buffer_external_sort_namespace
+
+template<typename Record, typename Compare>
+inline int ExternalSortWithOutBuffer(const char *input_path,
+                                     const char *output_path,
+                                     std::size_t memory_budget_bytes,
+                                     Compare comp,
+                                     std::size_t fan_in = 0) {
+  static_assert(std::is_trivially_copyable<Record>::value,
+                "Records stored in a file must be trivially copyable.");
+  using namespace merge_without_buffer_external_sort_namespace;
+  const std::size_t buffer_length = memory_budget_bytes / sizeof(Record);
+  if (buffer_length < 2)
+    return -EINVAL;
+  if (fan_in == 0)
+    fan_in = buffer_length / MWOB_EXTERNAL_SORT_MIN_WINDOW_RECORDS;
+  fan_in = std::max<std::size_t>(2, std::min(fan_in, buffer_length));
+  std::vector<Record> buffer(buffer_length);
+  std::vector<RunInfo> runs;
+  std::FILE *files[2] = { nullptr, nullptr };
+  std::FILE *output_file = nullptr;
+  int result = 0;
+
+  //(1) Run generation.
+  std::FILE *input_file = std::fopen(input_path, "rb");
+  if (input_file == nullptr)
+    return -errno;
+  off_t file_size = -1;
+  if (fseeko(input_file, 0, SEEK_END) != 0 ||
+      (file_size = ftello(input_file)) < 0 ||
+      fseeko(input_file, 0, SEEK_SET) != 0) {
+    result = -errno;
+    std::fclose(input_file);
+    return result;
+  }
+  if (file_size % static_cast<off_t>(sizeof(Record)) != 0) {
+    std::fclose(input_file);
+    return -EINVAL;
+  }
+  files[0] = std::tmpfile();
+  if (files[0] == nullptr) {
+    result = -errno;
+    std::fclose(input_file);
+    return result;
+  }
+  std::uint64_t num_records = 0;
+  while (true) {
+    std::size_t num_read = std::fread(buffer.data(), sizeof(Record),
+                                      buffer_length, input_file);
+    if (num_read < buffer_length && std::ferror(input_file)) {
+      result = -EIO;
+      break ;
+    }
+    if (num_read == 0)
+      break ;
+    StableSortWithOutBuffer(buffer.data(), buffer.data() + num_read, comp);
+    result = WriteRecords(files[0], buffer.data(), num_read);
+    if (result != 0)
+      break ;
+    runs.push_back(RunInfo{num_records, num_read});
+    num_records += num_read;
+    if (num_read < buffer_length)
+      break ;
+  }
+  std::fclose(input_file);
+
+  //(2) Merge passes.
+  std::size_t in_index = 0;
+  while (result == 0) {
+    bool is_last_pass = runs.size() <= fan_in;
+    std::FILE *out_file;
+    if (is_last_pass) {
+      out_file = output_file = std::fopen(output_path, "wb");
+    } else {
+      if (files[1 - in_index] == nullptr)
+        files[1 - in_index] = std::tmpfile();
+      else
+        std::rewind(files[1 - in_index]);
+      out_file = files[1 - in_index];
+    }
+    if (out_file == nullptr || std::fflush(files[in_index]) != 0) {
+      result = -errno;
+      break ;
+    }
+    std::vector<RunInfo> merged_runs;
+    std::uint64_t out_offset = 0;
+    for (std::size_t first = 0; first < runs.size() && result == 0;
+         first += fan_in) {
+      std::size_t num_runs = std::min(fan_in, runs.size() - first);
+      result = MergeRuns(files[in_index], runs.data() + first, num_runs,
+                         out_file, buffer.data(), buffer_length, comp);
+      std::uint64_t merged_length = 0;
+      for (std::size_t i = first; i < first + num_runs; i++)
+        merged_length += runs[i].length;
+      merged_runs.push_back(RunInfo{out_offset, merged_length});
+      out_offset += merged_length;
+    }
+    runs.swap(merged_runs);
+    if (is_last_pass)
+      break ;
+    in_index = 1 - in_index;
+  }
+
+  if (output_file != nullptr && std::fclose(output_file) != 0 && result == 0)
+    result = -errno;
+  for (std::FILE *file : files) {
+    if (file != nullptr)
+      std::fclose(file);
+  }
+  return result;
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) */
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_EXTERNAL_SORT_H_ */
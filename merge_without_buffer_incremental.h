@@ -0,0 +1,262 @@
+/*
+ * merge_without_buffer_incremental.h
+ *
+ *  IncrementalMergeWithOutBuffer is a resumable version of
+ *   MergeWithOutBuffer1() whose work is performed in bounded slices by calls
+ *   to Step(). This allows a very large merge to be interleaved with other
+ *   (e.g. latency-sensitive) work on the same thread.
+ *
+ *  The recursion of MergeWithOutBuffer1_recursive_RAI() is replaced by an
+ *   explicit work list (a stack) that holds three kinds of work items:
+ *  (1) Split items: a subproblem [start_left, start_right, one_past_end) of
+ *      two adjacent non-decreasing lists. If the subproblem is already ordered
+ *      then it is discarded. Otherwise the displacement d to the potential
+ *      medians is found by binary search (exactly as in
+ *      MergeWithOutBuffer1_recursive_RAI()) and the split item is replaced by
+ *      a swap item followed by the two resulting (smaller) split items.
+ *  (2) Swap items: the std::swap_ranges() of the last d elements of the left
+ *      list with the first d elements of the right list. This is performed in
+ *      chunks so that a single large swap can be spread over many Step()s.
+ *  (3) Leaf items: split items whose total length is at most leaf_length are
+ *      merged by a single call to MergeWithOutBuffer1().
+ *
+ *  Step(max_work) performs work items until performing the next work item
+ *   would make the total work performed by this call exceed max_work, where
+ *   one unit of work is one comparison or one swap/move (leaf items are
+ *   charged an estimate of length * log2(length) units).
+ *  Every call to Step() makes progress: at least one work item (or one chunk
+ *   of a swap item) is always performed, so a single call may exceed max_work
+ *   by at most the cost of one indivisible work item, which is either a
+ *   binary search (about log2(n) comparisons) or a leaf merge. Choosing
+ *   leaf_length to be small relative to max_work avoids this.
+ *
+ *  Invariant: between work items, the range [start_left, one_past_end) is
+ *   a sequence of consecutive blocks such that every element of a block is
+ *   less than or equal to every element of all blocks to its right, and each
+ *   block either is sorted or consists of two adjacent sorted lists (namely a
+ *   pending split item). This holds whenever no swap item is partially
+ *   performed (see IsAtSubproblemBoundary()).
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> vec = ...; //[0, length_left) and [length_left, size) sorted
+  IncrementalMergeWithOutBuffer<std::vector<int>::iterator, std::less<int>>
+      merge(vec.begin(), vec.begin() + length_left, vec.end(),
+            std::less<int>());
+  while (!merge.Step(10000)) {
+    //Do other work.
+  }
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_INCREMENTAL_H_
+#define SRC_MERGE_WITHOUT_BUFFER_INCREMENTAL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "merge_without_buffer_common.h"
+#include "merge_without_buffer1.h"
+
+#ifndef MWOB_INCREMENTAL_DEFAULT_LEAF_LENGTH
+#define MWOB_INCREMENTAL_DEFAULT_LEAF_LENGTH 64
+#endif
+
+template<typename RandomAccessIterator,
+         typename Compare = std::less<
+              typename std::iterator_traits<RandomAccessIterator>::value_type>>
+class IncrementalMergeWithOutBuffer {
+  static_assert(std::is_base_of<std::random_access_iterator_tag,
+      typename std::iterator_traits<RandomAccessIterator>::iterator_category
+                                >::value,
+      "IncrementalMergeWithOutBuffer requires random access iterators.");
+public:
+  typedef typename std::iterator_traits<RandomAccessIterator>::difference_type
+                                                                      Distance;
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  typedef std::size_t SizeType;
+
+  IncrementalMergeWithOutBuffer(RandomAccessIterator start_left,
+                    RandomAccessIterator start_right,
+                    RandomAccessIterator one_past_end,
+                    Compare comp = Compare(),
+                    Distance leaf_length = MWOB_INCREMENTAL_DEFAULT_LEAF_LENGTH)
+      : comp_(comp),
+        leaf_length_(leaf_length < 2 ? 2 : leaf_length) {
+    PushSplit(start_left, start_right, one_past_end);
+    return ;
+  }
+
+  //Performs at most (about) max_work comparisons and swaps, as described at
+  // the top of this file. Returns true if and only if the merge is complete.
+  bool Step(SizeType max_work) {
+    SizeType work_done = 0;
+    bool is_first_item = true;
+    while (!work_list_.empty()) {
+      SizeType remaining = work_done < max_work ? max_work - work_done : 0;
+      if (work_list_.back().kind == WorkItemKind::Swap) {
+        if (remaining == 0) {
+          if (!is_first_item)
+            break ;
+          remaining = 1;
+        }
+      } else if (!is_first_item &&
+                 EstimatedCost(work_list_.back()) > remaining) {
+        break ;
+      }
+      is_first_item = false;
+      work_done += Perform(remaining);
+    }
+    total_work_done_ += work_done;
+    return work_list_.empty();
+  }
+
+  //Runs the merge to completion.
+  void Finish() {
+    while (!Step(static_cast<SizeType>(-1) / 2)) ;
+    return ;
+  }
+
+  bool IsDone() const { return work_list_.empty(); }
+
+  //Returns true if no swap item is partially performed, in which case the
+  // invariant described at the top of this file holds.
+  bool IsAtSubproblemBoundary() const {
+    return work_list_.empty() || work_list_.back().kind != WorkItemKind::Swap
+           || work_list_.back().length_left == work_list_.back().length_swap;
+  }
+
+  //If a swap item is partially performed then performs the rest of it, and
+  // nothing else, after which IsAtSubproblemBoundary() is true. Returns the
+  // amount of work that was performed.
+  SizeType FinishPartialSwap() {
+    if (IsAtSubproblemBoundary())
+      return 0;
+    SizeType work_done = Perform(
+                         static_cast<SizeType>(work_list_.back().length_left));
+    total_work_done_ += work_done;
+    return work_done;
+  }
+
+  SizeType NumberOfPendingWorkItems() const { return work_list_.size(); }
+  SizeType TotalWorkDone() const { return total_work_done_; }
+
+private:
+  enum class WorkItemKind : unsigned char {
+    Split = 0,
+    Swap
+  };
+
+  //For a split item, [start_left, start_right) and [start_right, one_past_end)
+  // are the two lists and length_left, length_right are their lengths.
+  //For a swap item, [start_left, start_left + length_left) is swapped with
+  // [start_right, start_right + length_left), where length_left is the
+  // number of elements that have yet to be swapped and length_swap is the
+  // total number of elements that were to be swapped.
+  struct WorkItem {
+    WorkItemKind kind;
+    RandomAccessIterator start_left;
+    RandomAccessIterator start_right;
+    RandomAccessIterator one_past_end;
+    Distance length_left;
+    Distance length_right;
+    Distance length_swap;
+  };
+
+  static SizeType Log2Ceil(Distance n) {
+    SizeType log = 1;
+    while ((static_cast<Distance>(1) << log) < n)
+      log++;
+    return log;
+  }
+
+  SizeType EstimatedCost(const WorkItem &item) const {
+    if (item.kind == WorkItemKind::Swap)
+      return static_cast<SizeType>(item.length_left);
+    Distance length = item.length_left + item.length_right;
+    if (length <= leaf_length_)
+      return static_cast<SizeType>(length) * Log2Ceil(length);
+    Distance length_smaller = std::min(item.length_left, item.length_right);
+    return Log2Ceil(length_smaller) + 2;
+  }
+
+  void PushSplit(RandomAccessIterator start_left,
+                 RandomAccessIterator start_right,
+                 RandomAccessIterator one_past_end) {
+    Distance length_left  = start_right - start_left;
+    Distance length_right = one_past_end - start_right;
+    if (length_left <= 0 || length_right <= 0)
+      return ;
+    work_list_.push_back(WorkItem{WorkItemKind::Split, start_left, start_right,
+                         one_past_end, length_left, length_right, 0});
+    return ;
+  }
+
+  //Performs the work item at the back of the work list (or, if it is a swap
+  // item, at most max_swaps of its swaps) and returns the amount of work that
+  // was performed.
+  SizeType Perform(SizeType max_swaps) {
+    WorkItem item = work_list_.back();
+    if (item.kind == WorkItemKind::Swap) {
+      Distance num_swaps = std::min(item.length_left,
+                                    static_cast<Distance>(max_swaps));
+      std::swap_ranges(item.start_left, item.start_left + num_swaps,
+                       item.start_right);
+      if (num_swaps == item.length_left) {
+        work_list_.pop_back();
+      } else {
+        WorkItem &back   = work_list_.back();
+        back.start_left  += num_swaps;
+        back.start_right += num_swaps;
+        back.length_left -= num_swaps;
+      }
+      return static_cast<SizeType>(num_swaps);
+    }
+    work_list_.pop_back();
+    auto comp    = comp_;
+    auto comp_le = [comp](const ValueType &lhs, const ValueType &rhs) -> bool {
+      return !comp(rhs, lhs);
+    };
+    auto end_left = item.start_right - 1;
+    if (comp_le(*end_left, *item.start_right))
+      return 1; //Already merged.
+    if (item.length_left + item.length_right <= leaf_length_) {
+      MergeWithOutBuffer1<RandomAccessIterator, Compare, Distance>(
+          item.start_left, item.start_right, item.one_past_end,
+          item.length_left, item.length_right, comp_);
+      return EstimatedCost(item);
+    }
+    Distance length_smaller = std::min(item.length_left, item.length_right);
+    Distance d = mwob_namespace::DisplacementToPotentialMedians_KnownToExist_RAI<
+        RandomAccessIterator, Compare, Distance, decltype(comp_le), ValueType>(
+            end_left, item.start_right, length_smaller, comp, comp_le);
+    //DisplacementToPotentialMedians_KnownToExist_RAI() returns
+    // length_smaller - 1 also when no such d exists (i.e. when the entire
+    // shorter list must be moved across start_right).
+    if (d == length_smaller - 1 &&
+        !comp_le(*(end_left - d), *(item.start_right + d)))
+      d = length_smaller;
+    //assert(d > 0);
+    //Pushed in the reverse order in which they are to be performed.
+    PushSplit(item.start_right, item.start_right + d, item.one_past_end);
+    PushSplit(item.start_left, item.start_right - d, item.start_right);
+    work_list_.push_back(WorkItem{WorkItemKind::Swap, item.start_right - d,
+                         item.start_right, item.start_right + d, d, d, d});
+    return Log2Ceil(length_smaller) + 2;
+  }
+
+  Compare comp_;
+  Distance leaf_length_;
+  std::vector<WorkItem> work_list_;
+  SizeType total_work_done_ = 0;
+};
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_INCREMENTAL_H_ */
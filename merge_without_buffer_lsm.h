@@ -0,0 +1,203 @@
+/*
+ * merge_without_buffer_lsm.h
+ *
+ *  LsmSortedArray<T, Compare> ingests a stream of unsorted batches while
+ *   keeping all of its elements in a single contiguous std::vector<T> that
+ *   is organized, like a log-structured merge (LSM) tree, as a sequence of
+ *   sorted runs: the oldest run is at the front and the newest at the back.
+ *  Ingest() appends a batch, sorts it in place by StableSortWithOutBuffer(),
+ *   records it as a new run at level 0, and then applies the compaction
+ *   policy, which decides which adjacent runs are merged in place by
+ *   MergeWithOutBuffer1():
+ *  (1) CompactionPolicy::Tiered: whenever the last size_ratio runs are all at
+ *      the same level L, they are merged into a single run at level L + 1.
+ *      Elements are rewritten less often but there are more runs to search.
+ *  (2) CompactionPolicy::Leveled: whenever the second to last run is at most
+ *      size_ratio times as long as the last run, the two are merged. Run
+ *      lengths therefore decrease geometrically from front to back, so there
+ *      are O(log_{size_ratio}(N)) runs to search.
+ *  Because runs are only ever merged with adjacent runs and MergeWithOutBuffer1
+ *   is stable, equivalent elements always remain in the order in which they
+ *   were ingested.
+ *  Count(), Contains(), and LowerBoundInRun() binary search each run.
+ *   CompactAll() merges all runs into one, after which [begin(), end()) is a
+ *   consistent sorted view of every ingested element.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  LsmSortedArray<int> lsm(LsmSortedArray<int>::CompactionPolicy::Leveled, 4);
+  for (const std::vector<int> &batch : batches)
+    lsm.Ingest(batch.begin(), batch.end());
+  std::size_t num_zeros = lsm.Count(0);
+  lsm.CompactAll();
+  for (auto it = lsm.begin(); it != lsm.end(); it++)
+    std::cout << *it << '\n';
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_LSM_H_
+#define SRC_MERGE_WITHOUT_BUFFER_LSM_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "merge_without_buffer1.h"
+#include "merge_without_buffer_sort.h"
+
+#ifndef MWOB_LSM_DEFAULT_SIZE_RATIO
+#define MWOB_LSM_DEFAULT_SIZE_RATIO 4
+#endif
+
+template<typename T, typename Compare = std::less<T>>
+class LsmSortedArray {
+public:
+  typedef std::size_t SizeType;
+  typedef typename std::vector<T>::const_iterator const_iterator;
+
+  enum class CompactionPolicy {
+    Tiered = 0,
+    Leveled
+  };
+
+  //A sorted run [start, start + length) of the underlying array.
+  struct Run {
+    SizeType start;
+    SizeType length;
+    SizeType level;
+  };
+
+  explicit LsmSortedArray(
+                  CompactionPolicy policy = CompactionPolicy::Leveled,
+                  SizeType size_ratio = MWOB_LSM_DEFAULT_SIZE_RATIO,
+                  Compare comp = Compare())
+      : policy_(policy),
+        size_ratio_(size_ratio < 2 ? 2 : size_ratio),
+        comp_(comp) {
+  }
+
+  //Appends the batch [start, one_past_end), sorts it, and compacts runs as
+  // dictated by the compaction policy.
+  template<typename InputIterator>
+  void Ingest(InputIterator start, InputIterator one_past_end) {
+    SizeType run_start = data_.size();
+    data_.insert(data_.end(), start, one_past_end);
+    SizeType run_length = data_.size() - run_start;
+    if (run_length == 0)
+      return ;
+    StableSortWithOutBuffer(data_.begin() + run_start, data_.end(), comp_);
+    runs_.push_back(Run{run_start, run_length, 0});
+    Compact();
+    return ;
+  }
+
+  //Merges all runs into a single run.
+  void CompactAll() {
+    while (runs_.size() > 1) {
+      //Merge neighbouring pairs so that each element is moved O(log(#runs))
+      // times instead of O(#runs) times.
+      SizeType num_merged = 0;
+      for (SizeType i = 0; i < runs_.size(); i += 2) {
+        if (i + 1 < runs_.size()) {
+          MergeRuns(runs_[i], runs_[i + 1]);
+          runs_[i].level = std::max(runs_[i].level, runs_[i + 1].level) + 1;
+        }
+        runs_[num_merged++] = runs_[i];
+      }
+      runs_.resize(num_merged);
+    }
+    return ;
+  }
+
+  bool IsFullyCompacted() const { return runs_.size() <= 1; }
+
+  SizeType Count(const T &value) const {
+    SizeType num = 0;
+    for (const Run &run : runs_) {
+      auto range = std::equal_range(data_.begin() + run.start,
+                           data_.begin() + run.start + run.length, value, comp_);
+      num += static_cast<SizeType>(range.second - range.first);
+    }
+    return num;
+  }
+
+  bool Contains(const T &value) const {
+    for (const Run &run : runs_) {
+      auto one_past_end = data_.begin() + run.start + run.length;
+      auto it = std::lower_bound(data_.begin() + run.start, one_past_end,
+                                 value, comp_);
+      if (it != one_past_end && !comp_(value, *it))
+        return true;
+    }
+    return false;
+  }
+
+  //Returns the first element of run run_index that is not less than value.
+  const_iterator LowerBoundInRun(SizeType run_index, const T &value) const {
+    const Run &run = runs_[run_index];
+    return std::lower_bound(data_.begin() + run.start,
+                        data_.begin() + run.start + run.length, value, comp_);
+  }
+
+  //[begin(), end()) is sorted if IsFullyCompacted().
+  const_iterator begin() const { return data_.cbegin(); }
+  const_iterator end()   const { return data_.cend(); }
+
+  SizeType Size() const { return data_.size(); }
+  SizeType NumberOfRuns() const { return runs_.size(); }
+  const std::vector<Run> &Runs() const { return runs_; }
+  void Reserve(SizeType capacity) { data_.reserve(capacity); return ; }
+
+private:
+  //Merges the adjacent runs left and right in place and stores the result
+  // in left.
+  void MergeRuns(Run &left, const Run &right) {
+    //assert(left.start + left.length == right.start);
+    auto start_left  = data_.begin() + left.start;
+    auto start_right = start_left + left.length;
+    MergeWithOutBuffer1(start_left, start_right, start_right + right.length,
+                        comp_);
+    left.length += right.length;
+    return ;
+  }
+
+  void Compact() {
+    if (policy_ == CompactionPolicy::Tiered) {
+      while (runs_.size() >= size_ratio_) {
+        SizeType first = runs_.size() - size_ratio_;
+        SizeType level = runs_.back().level;
+        bool is_same_level = true;
+        for (SizeType i = first; i < runs_.size(); i++)
+          is_same_level = is_same_level && runs_[i].level == level;
+        if (!is_same_level)
+          break ;
+        for (SizeType i = first + 1; i < runs_.size(); i++)
+          MergeRuns(runs_[first], runs_[i]);
+        runs_[first].level = level + 1;
+        runs_.resize(first + 1);
+      }
+    } else {
+      while (runs_.size() >= 2 && runs_[runs_.size() - 2].length
+                                  <= size_ratio_ * runs_.back().length) {
+        Run &left = runs_[runs_.size() - 2];
+        MergeRuns(left, runs_.back());
+        left.level = std::max(left.level, runs_.back().level) + 1;
+        runs_.pop_back();
+      }
+    }
+    return ;
+  }
+
+  CompactionPolicy policy_;
+  SizeType size_ratio_;
+  Compare comp_;
+  std::vector<T> data_;
+  std::vector<Run> runs_;
+};
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_LSM_H_ */
@@ -0,0 +1,151 @@
+/*
+ * merge_without_buffer_mmap.h
+ *
+ *  MergeWithOutBufferMappedFile() merges, in place, a file of fixed-width
+ *   records that consists of two adjacent sorted runs: records
+ *   [0, num_records_left) and [num_records_left, num_records). The file is
+ *   memory-mapped (MAP_SHARED) and merged through the mapping by
+ *   MergeWithOutBuffer1(), so neither a copy of the file nor anonymous memory
+ *   the size of the file is needed; the kernel pages records in and out as
+ *   the merge touches them.
+ *
+ *  The madvise() access hints follow the phases of the merge:
+ *  (1) Trimming: the records at the front of the left run that are already in
+ *      place and the records at the back of the right run that are already in
+ *      place are found by binary searches, so the mapping is advised
+ *      MADV_RANDOM to avoid useless read-ahead.
+ *  (2) Merging: only the records between the two trimmed ends are moved, so
+ *      only that range is advised MADV_NORMAL (which re-enables read-ahead)
+ *      and MADV_WILLNEED.
+ *  If should_msync is true then msync(MS_SYNC) is called before unmapping.
+ *
+ *  Returns 0 on success and -errno on failure (-EINVAL if the file's size is
+ *   not a multiple of sizeof(Record) or if num_records_left is too large).
+ *  Record must be trivially copyable since its bytes are the file's bytes.
+ *  This file requires a POSIX system; on other systems the function is not
+ *   declared.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  struct Record { std::uint64_t key; char payload[56]; };
+  auto comp = [](const Record &lhs, const Record &rhs) -> bool {
+    return lhs.key < rhs.key;
+  };
+  int result = MergeWithOutBufferMappedFile<Record>("segment.dat",
+                                                    num_records_left, comp);
+  if (result != 0)
+    std::cerr << "Merge failed: " << std::strerror(-result) << '\n';
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_MMAP_H_
+#define SRC_MERGE_WITHOUT_BUFFER_MMAP_H_
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "merge_without_buffer1.h"
+
+namespace merge_without_buffer_mmap_namespace {
+
+//Calls madvise() on the pages that contain [start, one_past_end), which must
+// lie within the mapping that starts at mapping_start (which is page aligned).
+//The advice is only a hint so failures are ignored.
+inline void AdviseRange(void *mapping_start,
+                        const void *start,
+                        const void *one_past_end,
+                        int advice) {
+  if (start >= one_past_end)
+    return ;
+  std::uintptr_t page_size =
+                          static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+  std::uintptr_t mapping = reinterpret_cast<std::uintptr_t>(mapping_start);
+  std::uintptr_t first   = reinterpret_cast<std::uintptr_t>(start);
+  std::uintptr_t last    = reinterpret_cast<std::uintptr_t>(one_past_end);
+  first = std::max(mapping, first - (first % page_size));
+  (void)madvise(reinterpret_cast<void *>(first),
+                static_cast<std::size_t>(last - first), advice);
+  return ;
+}
+
+} //END namespace: merge_without_buffer_mmap_namespace
+
+template<typename Record, typename Compare>
+inline int MergeWithOutBufferMappedFile(const char *path,
+                                        std::size_t num_records_left,
+                                        Compare comp,
+                                        bool should_msync = true) {
+  static_assert(std::is_trivially_copyable<Record>::value,
+                "Records stored in a file must be trivially copyable.");
+  using merge_without_buffer_mmap_namespace::AdviseRange;
+  int fd = open(path, O_RDWR);
+  if (fd < 0)
+    return -errno;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    int error = errno;
+    close(fd);
+    return -error;
+  }
+  std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+  if (file_size % sizeof(Record) != 0 ||
+      num_records_left > file_size / sizeof(Record)) {
+    close(fd);
+    return -EINVAL;
+  }
+  std::size_t num_records = file_size / sizeof(Record);
+  if (num_records_left == 0 || num_records_left == num_records) {
+    close(fd);
+    return 0;
+  }
+  void *mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+  if (mapping == MAP_FAILED) {
+    int error = errno;
+    close(fd);
+    return -error;
+  }
+  Record *start_left         = static_cast<Record *>(mapping);
+  Record *start_right        = start_left + num_records_left;
+  Record *one_past_end_right = start_left + num_records;
+
+  //Phase 1: trimming (binary searches).
+  AdviseRange(mapping, start_left, one_past_end_right, MADV_RANDOM);
+  if (comp(*start_right, *(start_right - 1))) {
+    start_left = std::upper_bound(start_left, start_right, *start_right, comp);
+    one_past_end_right = std::lower_bound(start_right, one_past_end_right,
+                                          *(start_right - 1), comp);
+    //Phase 2: merging the records that are not yet in place.
+    AdviseRange(mapping, start_left, one_past_end_right, MADV_NORMAL);
+    AdviseRange(mapping, start_left, one_past_end_right, MADV_WILLNEED);
+    MergeWithOutBuffer1<Record *, Compare, std::ptrdiff_t>(start_left,
+        start_right, one_past_end_right, start_right - start_left,
+        one_past_end_right - start_right, comp);
+  }
+
+  int result = 0;
+  if (should_msync && msync(mapping, file_size, MS_SYNC) != 0)
+    result = -errno;
+  if (munmap(mapping, file_size) != 0 && result == 0)
+    result = -errno;
+  if (close(fd) != 0 && result == 0)
+    result = -errno;
+  return result;
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) */
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_MMAP_H_ */
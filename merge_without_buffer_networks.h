@@ -0,0 +1,247 @@
+/*
+ * merge_without_buffer_networks.h
+ *
+ *  MergeWithOutBufferN<L, R>(start, comp) merges the sorted lists
+ *   [start, start + L) and [start + L, start + L + R), whose lengths are
+ *   known at compile time, with a fully unrolled merge network of
+ *   compare-exchange operations that contains no data dependent branches.
+ *
+ *  The network is generated at compile time by MakeMergeNetwork<L, R>():
+ *   both lists are conceptually padded with +infinity to the same power of
+ *   two length H, after which the two padded (sorted) lists are merged by a
+ *   bitonic merger of 2H slots (a "flip" stage that compares slot i with slot
+ *   2H - 1 - i followed by half-cleaners). Since +infinity is larger than
+ *   everything, where the padding values end up does not depend on the data,
+ *   so compare-exchanges that involve padding are resolved at compile time
+ *   and only those between two actual values are emitted. The values are
+ *   loaded into a local array, the network is run on it, and the results are
+ *   stored back in order.
+ *
+ *  Merge networks are NOT stable: equivalent elements may be reordered.
+ *   MergeWithOutBuffer1() and MergeWithOutBuffer2() therefore only hand a
+ *   recursion leaf to a network (through the dispatch table in
+ *   MergeByNetwork(), for lengths of at most MWOB_MERGE_NETWORK_MAX_LENGTH)
+ *   when this cannot be observed, which is when the value type is integral
+ *   and comp is std::less or std::greater, so that equivalent values are
+ *   equal (see IsMergeNetworkUsable). Define MWOB_MERGE_NETWORK_MAX_LENGTH to
+ *   be 0 to disable this.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  int a[7] = {1, 4, 6, 9, 2, 3, 8}; //[1, 4, 6, 9] and [2, 3, 8]
+  MergeWithOutBufferN<4, 3>(a, std::less<int>());
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_NETWORKS_H_
+#define SRC_MERGE_WITHOUT_BUFFER_NETWORKS_H_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+//Recursion leaves whose lists both have at most this many elements are
+// merged by a merge network (if IsMergeNetworkUsable). Each (iterator,
+// comparator) pair instantiates MWOB_MERGE_NETWORK_MAX_LENGTH^2 networks so
+// larger values noticeably increase compile times.
+#ifndef MWOB_MERGE_NETWORK_MAX_LENGTH
+#define MWOB_MERGE_NETWORK_MAX_LENGTH 8
+#endif
+
+namespace mwob_namespace {
+
+//A compare-exchange of the values at indices lower and upper, after which
+// the value at lower is not greater than the value at upper.
+struct MergeNetworkOperation {
+  int lower;
+  int upper;
+};
+
+constexpr int NextPowerOf2(int n) {
+  int power = 1;
+  while (power < n)
+    power *= 2;
+  return power;
+}
+
+constexpr int Log2(int power_of_2) {
+  int log2 = 0;
+  while (power_of_2 > 1) {
+    power_of_2 /= 2;
+    log2++;
+  }
+  return log2;
+}
+
+template<int L, int R>
+struct MergeNetwork {
+  static constexpr int half_slots = NextPowerOf2(L > R ? L : R);
+  static constexpr int num_slots  = 2 * half_slots;
+  //The flip stage and the half-cleaners each have half_slots
+  // compare-exchanges and there are log2(num_slots) stages.
+  static constexpr int max_num_operations = half_slots * Log2(num_slots);
+
+  MergeNetworkOperation operations[max_num_operations] = {};
+  int num_operations = 0;
+  //output[i] is the index, in the local array, of the i'th smallest value.
+  int output[L + R] = {};
+};
+
+template<int L, int R>
+constexpr MergeNetwork<L, R> MakeMergeNetwork() {
+  typedef MergeNetwork<L, R> Network;
+  Network network{};
+  //slot_to_index[s] is the index of the value that is in slot s or -1 if
+  // slot s contains +infinity.
+  int slot_to_index[Network::num_slots] = {};
+  for (int s = 0; s < Network::half_slots; s++) {
+    slot_to_index[s] = s < L ? s : -1;
+    slot_to_index[Network::half_slots + s] = s < R ? L + s : -1;
+  }
+  auto compare_exchange = [&network, &slot_to_index](int lower_slot,
+                                                     int upper_slot) {
+    int lower = slot_to_index[lower_slot];
+    int upper = slot_to_index[upper_slot];
+    if (lower >= 0 && upper >= 0) {
+      network.operations[network.num_operations++] =
+                                              MergeNetworkOperation{lower, upper};
+    } else if (lower < 0 && upper >= 0) { //+infinity moves up.
+      slot_to_index[lower_slot] = upper;
+      slot_to_index[upper_slot] = -1;
+    }
+  };
+  for (int s = 0; s < Network::half_slots; s++)
+    compare_exchange(s, Network::num_slots - 1 - s);
+  for (int h = Network::half_slots / 2; h >= 1; h /= 2) {
+    for (int block = 0; block < Network::num_slots; block += 2 * h) {
+      for (int s = block; s < block + h; s++)
+        compare_exchange(s, s + h);
+    }
+  }
+  for (int i = 0; i < L + R; i++)
+    network.output[i] = slot_to_index[i];
+  return network;
+}
+
+template<int L, int R>
+struct MergeNetworkHolder {
+  static constexpr MergeNetwork<L, R> network = MakeMergeNetwork<L, R>();
+};
+
+template<typename ValueType, typename Compare>
+inline void CompareExchange(ValueType &lower, ValueType &upper, Compare comp) {
+  ValueType lower_value = lower;
+  ValueType upper_value = upper;
+  bool is_swapped = comp(upper_value, lower_value);
+  lower = is_swapped ? upper_value : lower_value;
+  upper = is_swapped ? lower_value : upper_value;
+  return ;
+}
+
+template<int L, int R, typename ValueType, typename Compare,
+         std::size_t... OperationIndices>
+inline void ApplyMergeNetwork(ValueType *values, Compare comp,
+                              std::index_sequence<OperationIndices...>) {
+  constexpr const MergeNetwork<L, R> &network =
+                                             MergeNetworkHolder<L, R>::network;
+  (CompareExchange(values[network.operations[OperationIndices].lower],
+                   values[network.operations[OperationIndices].upper], comp),
+   ...);
+  return ;
+}
+
+template<int L, int R, typename RandomAccessIterator, std::size_t... Indices>
+inline void StoreMergeNetworkOutput(RandomAccessIterator start,
+             const typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                       *values,
+             std::index_sequence<Indices...>) {
+  constexpr const MergeNetwork<L, R> &network =
+                                             MergeNetworkHolder<L, R>::network;
+  ((*(start + Indices) = values[network.output[Indices]]), ...);
+  return ;
+}
+
+//True if merging by a merge network is indistinguishable from a stable merge.
+template<typename ValueType, typename Compare>
+struct IsMergeNetworkUsable
+    : std::integral_constant<bool, std::is_integral<ValueType>::value && (
+           std::is_same<Compare, std::less<ValueType>>::value
+        || std::is_same<Compare, std::less<>>::value
+        || std::is_same<Compare, std::greater<ValueType>>::value
+        || std::is_same<Compare, std::greater<>>::value)> {
+};
+
+} //END namespace: mwob_namespace
+
+template<int L, int R, typename RandomAccessIterator, typename Compare>
+inline void MergeWithOutBufferN(RandomAccessIterator start, Compare comp) {
+  static_assert(L >= 0 && R >= 0, "The lengths must be non-negative.");
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  if constexpr (L > 0 && R > 0) {
+    ValueType values[L + R];
+    for (int i = 0; i < L + R; i++)
+      values[i] = *(start + i);
+    mwob_namespace::ApplyMergeNetwork<L, R>(values, comp,
+        std::make_index_sequence<static_cast<std::size_t>(
+              mwob_namespace::MergeNetworkHolder<L, R>::network.num_operations)>());
+    mwob_namespace::StoreMergeNetworkOutput<L, R>(start, values,
+        std::make_index_sequence<static_cast<std::size_t>(L + R)>());
+  }
+  return ;
+}
+
+template<int L, int R, typename RandomAccessIterator>
+inline void MergeWithOutBufferN(RandomAccessIterator start) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  MergeWithOutBufferN<L, R>(start, std::less<ValueType>());
+  return ;
+}
+
+namespace mwob_namespace {
+
+template<typename RandomAccessIterator, typename Compare>
+struct MergeNetworkTable {
+  typedef void (*FunctionType)(RandomAccessIterator, Compare);
+  static constexpr int max_length = MWOB_MERGE_NETWORK_MAX_LENGTH > 0 ?
+                                    MWOB_MERGE_NETWORK_MAX_LENGTH : 1;
+
+  template<std::size_t... Indices>
+  static constexpr auto MakeTable(std::index_sequence<Indices...>) {
+    struct Table {
+      FunctionType functions[sizeof...(Indices)];
+    };
+    return Table{{&MergeWithOutBufferN<static_cast<int>(Indices / max_length) + 1,
+                                       static_cast<int>(Indices % max_length) + 1,
+                                       RandomAccessIterator, Compare>...}};
+  }
+
+  static constexpr auto table = MakeTable(
+      std::make_index_sequence<static_cast<std::size_t>(max_length * max_length)>());
+};
+
+//Merges [start_left, start_left + length_left) and
+// [start_left + length_left, start_left + length_left + length_right) by
+// calling the network for these lengths through a table of function
+// pointers.
+//Assumes that: 0 < length_left, length_right <= MWOB_MERGE_NETWORK_MAX_LENGTH
+template<typename RandomAccessIterator, typename Compare, typename Distance>
+inline void MergeByNetwork(RandomAccessIterator start_left,
+                           Distance length_left,
+                           Distance length_right,
+                           Compare comp) {
+  typedef MergeNetworkTable<RandomAccessIterator, Compare> Table;
+  Table::table.functions[(length_left - 1) * Table::max_length
+                          + (length_right - 1)](start_left, comp);
+  return ;
+}
+
+} //END namespace: mwob_namespace
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_NETWORKS_H_ */
@@ -0,0 +1,117 @@
+/*
+ * merge_without_buffer_partial.h
+ *
+ *  PartialMergeWithOutBuffer(start_left, start_right, one_past_end, k, comp)
+ *   only guarantees that [start_left, start_left + k) holds, in order, the
+ *   first k elements of the stable merge of the sorted lists
+ *   [start_left, start_right) and [start_right, one_past_end) (e.g. for a
+ *   top-k query), which is much less work than the full merge when k is
+ *   small.
+ *
+ *  CoRank() finds the split (i, j), with i + j == k, such that these k
+ *   elements are the first i elements of the left list and the first j
+ *   elements of the right list. The j right elements are moved to
+ *   [start_left + i, start_left + k) and the two lists of lengths i and j
+ *   that now make up the first k positions are merged by
+ *   MergeWithOutBuffer1(), so that only O(k) elements are moved and no
+ *   subproblem of the merge that lies past position k is ever started:
+ *  (1) If k < length_left then j < length_left - i and the j right elements
+ *      are swapped (by SwapBlocks()) with the j left elements that occupy
+ *      [start_left + i, start_left + k). This leaves the last
+ *      length_left - i elements of the left list permuted: they are
+ *      [start_right, start_right + j) followed by
+ *      [start_left + k, start_right).
+ *  (2) Otherwise the j right elements are rotated (by RotateBlocks()) in
+ *      front of the remaining length_left - i < j left elements, which
+ *      moves fewer than 2 * k elements and leaves the latter sorted.
+ *
+ *  Afterwards [start_left + k, one_past_end) holds the last length_left - i
+ *   elements of the left list (permuted as in (1)) followed by the last
+ *   length_right - j elements of the right list, and the returned iterator
+ *   is the start of the latter. The merge can be finished later by
+ *   RotateWithOutBuffer(start_left + k, start_right, returned_iterator)
+ *   (only if start_left + k < start_right) followed by
+ *   MergeWithOutBuffer1(start_left + k, returned_iterator, one_past_end,
+ *   comp).
+ *
+ *  The iterators must be random access iterators.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> vec({ 1, 4, 6, 9, 12, 0, 2, 3, 8, 10 });
+  //vec[0, 5) and vec[5, 10) are sorted.
+  auto middle = PartialMergeWithOutBuffer(vec.begin(), vec.begin() + 5,
+                                          vec.end(), 4);
+  //vec is now { 0, 1, 2, 3, 12, 4, 6, 9, 8, 10 } and
+  // middle == vec.begin() + 8.
+  //The merge can be completed later with:
+  RotateWithOutBuffer(vec.begin() + 4, vec.begin() + 5, middle);
+  MergeWithOutBuffer1(vec.begin() + 4, middle, vec.end());
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_PARTIAL_H_
+#define SRC_MERGE_WITHOUT_BUFFER_PARTIAL_H_
+
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "merge_without_buffer1.h"
+#include "merge_without_buffer_corank.h"
+
+template<typename RandomAccessIterator, typename Compare,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+inline RandomAccessIterator PartialMergeWithOutBuffer(
+                                       RandomAccessIterator start_left,
+                                       RandomAccessIterator start_right,
+                                       RandomAccessIterator one_past_end,
+                                       Distance k,
+                                       Compare comp) {
+  Distance length = one_past_end - start_left;
+  if (k >= length) {
+    MergeWithOutBuffer1(start_left, start_right, one_past_end, comp);
+    return one_past_end;
+  }
+  if (k <= 0)
+    return start_right;
+  std::pair<Distance, Distance> split =
+      CoRank<RandomAccessIterator, Compare, Distance>(start_left, start_right,
+                                                      start_right,
+                                                      one_past_end, k, comp);
+  RandomAccessIterator start_left_rest = start_left + split.first;
+  RandomAccessIterator one_past_end_prefix_right = start_right + split.second;
+  if (start_left + k < start_right)
+    mwob_namespace::SwapBlocks(start_right, one_past_end_prefix_right,
+                               start_left_rest);
+  else
+    mwob_namespace::RotateBlocks(start_left_rest, start_right,
+                                 one_past_end_prefix_right);
+  //[start_left, start_left + k) now consists of the first split.first left
+  // elements followed by the first split.second right elements, and the
+  // rest of the right list still starts at one_past_end_prefix_right.
+  MergeWithOutBuffer1(start_left, start_left_rest, start_left + k, comp);
+  return one_past_end_prefix_right;
+}
+
+template<typename RandomAccessIterator,
+         typename Distance =
+            typename std::iterator_traits<RandomAccessIterator>::difference_type>
+inline RandomAccessIterator PartialMergeWithOutBuffer(
+                                       RandomAccessIterator start_left,
+                                       RandomAccessIterator start_right,
+                                       RandomAccessIterator one_past_end,
+                                       Distance k) {
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                     ValueType;
+  return PartialMergeWithOutBuffer<RandomAccessIterator, std::less<ValueType>,
+                                   Distance>(start_left, start_right,
+                                             one_past_end, k,
+                                             std::less<ValueType>());
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_PARTIAL_H_ */
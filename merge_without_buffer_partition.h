@@ -0,0 +1,174 @@
+/*
+ * merge_without_buffer_partition.h
+ *
+ *  StablePartitionWithOutBuffer(start, one_past_end, pred) reorders
+ *   [start, one_past_end) so that the elements for which pred is true
+ *   precede those for which it is false while preserving the relative order
+ *   within both groups, and returns an iterator to the first element of the
+ *   second group (like std::stable_partition()). It never allocates memory.
+ *
+ *  It has the same divide, exchange blocks, and recurse structure as the
+ *   merges:
+ *  (1) Trim: the leading elements for which pred is true are already in
+ *      place and are skipped (as are, implicitly, the trailing elements for
+ *      which pred is false, since they are never moved).
+ *  (2) Divide: the rest, whose first element is known to be false, is cut
+ *      in half and both halves are partitioned recursively (the second half
+ *      is trimmed first), giving T1 F1 T2 F2.
+ *  (3) Exchange: F1 and T2 are exchanged by mwob_namespace::RotateBlocks(),
+ *      which uses the same block exchange kernels as the merges (i.e. tiled
+ *      SIMD block swaps for trivially copyable types stored contiguously and
+ *      cycle chasing for types whose moves are expensive).
+ *  Subranges of trivially copyable values stored contiguously that fit in
+ *   MWOB_PARTITION_STACK_BYTES bytes are instead partitioned in a single pass
+ *   through a fixed size array on the stack, which replaces the many short
+ *   rotations near the leaves of the recursion (where most of the moves are
+ *   performed) with about two moves per element. This uses O(1) memory and
+ *   never allocates.
+ *  pred is applied exactly once to each element. The recursion depth is
+ *   O(log(N)) and O(N log(N / B)) elements are moved, where B is the number
+ *   of elements that fit in MWOB_PARTITION_STACK_BYTES bytes (B = 1 if the
+ *   stack array is not used).
+ *  As in MergeWithOutBuffer1(), contiguous iterators (e.g.
+ *   std::vector<T>::iterator) are lowered to pointers.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> vec({ 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+  auto is_even = [](int value) -> bool { return value % 2 == 0; };
+  auto first_odd = StablePartitionWithOutBuffer(vec.begin(), vec.end(),
+                                                is_even);
+  //vec is now { 2, 4, 6, 8, 1, 3, 5, 7, 9 } and first_odd == vec.begin() + 4.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_PARTITION_H_
+#define SRC_MERGE_WITHOUT_BUFFER_PARTITION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "merge_without_buffer_common.h"
+
+//Subranges of trivially copyable values stored contiguously whose size in
+// bytes is at most this are partitioned in a single pass through an array of
+// this many bytes on the stack (0 disables this).
+#ifndef MWOB_PARTITION_STACK_BYTES
+#define MWOB_PARTITION_STACK_BYTES 1024
+#endif
+
+namespace merge_without_buffer_partition_namespace {
+
+//Stably partitions [start, one_past_end) by moving the true elements
+// towards start and the false elements into an array on the stack, from
+// which they are then copied back, and returns the partition point.
+//Assumes that: pred(*start) == false and
+//  (one_past_end - start) * sizeof(T) <= MWOB_PARTITION_STACK_BYTES
+template<typename T, typename Predicate>
+inline T *StablePartitionKnownFalseStartSmall_ptr(T *start, T *one_past_end,
+                                                  Predicate &pred) {
+  alignas(T) unsigned char falses[MWOB_PARTITION_STACK_BYTES > 0 ?
+                                  MWOB_PARTITION_STACK_BYTES : 1];
+  std::memcpy(falses, start, sizeof(T));
+  std::size_t num_bytes_false = sizeof(T);
+  T *out = start;
+  for (T *it = start + 1; it != one_past_end; it++) {
+    if (pred(*it)) {
+      std::memcpy(out, it, sizeof(T));
+      out++;
+    } else {
+      std::memcpy(falses + num_bytes_false, it, sizeof(T));
+      num_bytes_false += sizeof(T);
+    }
+  }
+  std::memcpy(out, falses, num_bytes_false);
+  return out;
+}
+
+//Stably partitions [start, one_past_end), which has the given length, and
+// returns the partition point.
+//Assumes that: length >= 1 and pred(*start) == false
+template<typename BidirectionalIterator, typename Predicate,
+         typename Distance>
+BidirectionalIterator StablePartitionKnownFalseStart(
+                                          BidirectionalIterator start,
+                                          BidirectionalIterator one_past_end,
+                                          Distance length,
+                                          Predicate &pred) {
+  if (length == 1)
+    return start;
+  if constexpr (MWOB_PARTITION_STACK_BYTES > 0 && mwob_namespace::
+                  IsTiledBlockExchangeUsed<BidirectionalIterator>::value) {
+    typedef typename std::iterator_traits<BidirectionalIterator>::value_type
+                                                                     ValueType;
+    if (static_cast<std::size_t>(length) * sizeof(ValueType)
+                                              <= MWOB_PARTITION_STACK_BYTES)
+      return StablePartitionKnownFalseStartSmall_ptr(start, one_past_end, pred);
+  }
+  Distance length_left = length / 2;
+  BidirectionalIterator middle = start;
+  std::advance(middle, length_left);
+  BidirectionalIterator split_left = StablePartitionKnownFalseStart(start,
+                                               middle, length_left, pred);
+  //Trim the right half's leading true elements.
+  Distance length_right = length - length_left;
+  BidirectionalIterator start_right = middle;
+  while (length_right > 0 && pred(*start_right)) {
+    (void)++start_right;
+    (void)--length_right;
+  }
+  BidirectionalIterator split_right = one_past_end;
+  if (length_right > 0) {
+    split_right = StablePartitionKnownFalseStart(start_right, one_past_end,
+                                                 length_right, pred);
+  }
+  //[start, one_past_end) is now T1 F1 T2 F2 where F1 = [split_left, middle)
+  // and T2 = [middle, split_right).
+  return mwob_namespace::RotateBlocks(split_left, middle, split_right);
+}
+
+template<typename BidirectionalIterator, typename Predicate>
+inline BidirectionalIterator StablePartition(
+                                          BidirectionalIterator start,
+                                          BidirectionalIterator one_past_end,
+                                          Predicate &pred) {
+  typedef typename std::iterator_traits<BidirectionalIterator>::difference_type
+                                                                      Distance;
+  //Trim the leading true elements.
+  while (start != one_past_end && pred(*start))
+    (void)++start;
+  if (start == one_past_end)
+    return start;
+  Distance length = std::distance(start, one_past_end);
+  return StablePartitionKnownFalseStart(start, one_past_end, length, pred);
+}
+
+} //END namespace: merge_without_buffer_partition_namespace
+
+template<typename BidirectionalIterator, typename Predicate>
+inline BidirectionalIterator StablePartitionWithOutBuffer(
+                                          BidirectionalIterator start,
+                                          BidirectionalIterator one_past_end,
+                                          Predicate pred) {
+  using merge_without_buffer_partition_namespace::StablePartition;
+  if constexpr (!std::is_pointer<BidirectionalIterator>::value &&
+        mwob_namespace::IsContiguousIterator<BidirectionalIterator>::value) {
+    //Lower contiguous iterators (e.g. std::vector<T>::iterator) to pointers.
+    if (start == one_past_end)
+      return start;
+    auto start_ptr = mwob_namespace::IteratorToPointer(start);
+    auto one_past_end_ptr = start_ptr + (one_past_end - start);
+    return start + (StablePartition(start_ptr, one_past_end_ptr, pred)
+                    - start_ptr);
+  } else {
+    return StablePartition(start, one_past_end, pred);
+  }
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_PARTITION_H_ */
@@ -0,0 +1,271 @@
+/*
+ * merge_without_buffer_records.h
+ *
+ *  MergeRecordsWithOutBuffer(base, num_records_left, num_records_right,
+ *   record_size, comp, context) merges, in place, the adjacent sorted runs
+ *   [0, num_records_left) and [num_records_left, num_records_left +
+ *   num_records_right) of records of record_size bytes each that start at
+ *   base, where record_size is only known at run time (e.g. rows whose
+ *   layout comes from a schema). Like qsort_r(), records are ordered by a
+ *   plain function comp(lhs, rhs, context) that returns a negative value,
+ *   zero, or a positive value if the record at lhs is less than, equivalent
+ *   to, or greater than the record at rhs. The merge is stable.
+ *
+ *  Records are treated as opaque bytes, so they must be trivially copyable,
+ *   base need not be aligned, and comp must not rely on the addresses it is
+ *   given (it may be passed pointers to copies of records).
+ *
+ *  If record_size is 8, 16, 32, or 64 then the records are merged by
+ *   MergeWithOutBuffer1() as arrays of FixedSizeRecord<record_size>, so that
+ *   its trims, unbalanced merges, and tiled block exchanges are used.
+ *  Records of any other size are merged by MergeRecords(), which has the
+ *   same trim, divide, and exchange structure as MergeWithOutBuffer1() but
+ *   addresses records by byte offsets: both runs are trimmed by binary
+ *   searches, the displacement d to the potential medians is found by a
+ *   binary search, the last d records of the left run are swapped with the
+ *   first d records of the right run, and the two halves are merged, the
+ *   smaller one recursively (so the recursion depth is O(log(N))). Since a
+ *   block of records is just a block of bytes, the swaps and rotations are
+ *   performed on the bytes by mwob_namespace::SwapBlocks() and
+ *   mwob_namespace::RotateBlocks() (i.e. by the tiled SIMD block swaps and
+ *   the std::memmove() based rotations).
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  //Rows of 12 bytes whose sort key is the 4 byte integer at offset 4.
+  auto by_key = [](const void *lhs, const void *rhs, void *) -> int {
+    std::int32_t lhs_key, rhs_key;
+    std::memcpy(&lhs_key, static_cast<const char *>(lhs) + 4, 4);
+    std::memcpy(&rhs_key, static_cast<const char *>(rhs) + 4, 4);
+    return (lhs_key > rhs_key) - (lhs_key < rhs_key);
+  };
+  //rows holds num_rows_left + num_rows_right rows, each run sorted by key.
+  MergeRecordsWithOutBuffer(rows.data(), num_rows_left, num_rows_right, 12,
+                            by_key, nullptr);
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_RECORDS_H_
+#define SRC_MERGE_WITHOUT_BUFFER_RECORDS_H_
+
+#include <cstddef>
+
+#include "merge_without_buffer1.h"
+
+//The type of the function that orders records, as in qsort_r().
+typedef int (*MwobRecordCompare)(const void *lhs, const void *rhs,
+                                 void *context);
+
+namespace merge_without_buffer_records_namespace {
+
+template<std::size_t Size>
+struct FixedSizeRecord {
+  unsigned char bytes[Size];
+};
+
+//Orders records of record_size bytes by a qsort_r() style comparison
+// function. Calling it on two FixedSizeRecords compares their bytes.
+struct RecordLess {
+  inline bool operator()(const unsigned char *lhs,
+                         const unsigned char *rhs) const {
+    return comp(lhs, rhs, context) < 0;
+  }
+  template<std::size_t Size>
+  inline bool operator()(const FixedSizeRecord<Size> &lhs,
+                         const FixedSizeRecord<Size> &rhs) const {
+    return comp(lhs.bytes, rhs.bytes, context) < 0;
+  }
+  MwobRecordCompare comp;
+  void *context;
+};
+
+//Returns the number of the length records starting at start that are less
+// than (resp. not greater than, if is_upper_bound is true) the record at
+// value, i.e. the index given by std::lower_bound() (resp. std::upper_bound()).
+//The index is found by galloping (i.e. exponential search followed by binary
+// search) from the front of the records if is_from_back is false and from
+// their back otherwise, so that it takes O(log(k)) comparisons where k is the
+// distance of the index from that end.
+inline std::size_t RecordBound(const unsigned char *start, std::size_t length,
+                               const unsigned char *value,
+                               std::size_t record_size, const RecordLess &comp,
+                               bool is_upper_bound, bool is_from_back) {
+  auto is_before_value = [&](std::size_t i) -> bool {
+    const unsigned char *record = start + i * record_size;
+    return is_upper_bound ? !comp(value, record) : comp(record, value);
+  };
+  //The index lies in [lower, upper].
+  std::size_t lower = 0, upper = length;
+  std::size_t step = 1;
+  if (is_from_back) {
+    while (step <= length && !is_before_value(length - step)) {
+      upper = length - step;
+      step *= 2;
+    }
+    if (step <= length)
+      lower = length - step + 1;
+  } else {
+    while (step <= length && is_before_value(step - 1)) {
+      lower = step;
+      step *= 2;
+    }
+    if (step <= length)
+      upper = step - 1;
+  }
+  while (lower < upper) {
+    std::size_t middle = lower + (upper - lower) / 2;
+    if (is_before_value(middle))
+      lower = middle + 1;
+    else
+      upper = middle;
+  }
+  return lower;
+}
+
+//If is_left_trimmed (resp. is_right_trimmed) is true then the first (resp.
+// last) record of the left (resp. right) run is known to be greater (resp.
+// less) than the first (resp. last) record of the right (resp. left) run, so
+// that trimming that run would not remove anything. At most one of them may
+// be true.
+//Assumes that: record_size > 0
+inline void MergeRecords(unsigned char *start_left,
+                         std::size_t length_left,
+                         std::size_t length_right,
+                         std::size_t record_size,
+                         const RecordLess &comp,
+                         bool is_left_trimmed,
+                         bool is_right_trimmed) {
+  while (length_left > 0 && length_right > 0) {
+    unsigned char *start_right = start_left + length_left * record_size;
+    unsigned char *end_left    = start_right - record_size;
+    //Trim the records at the front of the left run that are not greater than
+    // the first record of the right run and the records at the back of the
+    // right run that are not less than the last record of the left run. If
+    // the runs are already in order then one of them is trimmed away.
+    if (!is_left_trimmed) {
+      std::size_t num_in_place = RecordBound(start_left, length_left,
+                                   start_right, record_size, comp, true, false);
+      start_left  += num_in_place * record_size;
+      length_left -= num_in_place;
+      if (length_left == 0)
+        return ;
+    }
+    if (!is_right_trimmed) {
+      length_right = RecordBound(start_right, length_right, end_left,
+                                 record_size, comp, false, true);
+      if (length_right == 0)
+        return ;
+    }
+    //assert(length_left > 0 && length_right > 0);
+    if (length_left == 1) {
+      std::size_t position = RecordBound(start_right, length_right,
+                                 start_left, record_size, comp, false, false);
+      mwob_namespace::RotateBlocks(start_left, start_right,
+                                   start_right + position * record_size);
+      return ;
+    }
+    if (length_right == 1) {
+      std::size_t position = RecordBound(start_left, length_left,
+                                 start_right, record_size, comp, true, true);
+      mwob_namespace::RotateBlocks(start_left + position * record_size,
+                                   start_right, start_right + record_size);
+      return ;
+    }
+    //Find the least d such that the d-th record of the right run is not
+    // less than the d-th last record of the left run (d = 0 is excluded
+    // since the trims leave the first record of the right run less than the
+    // last record of the left run).
+    std::size_t d_lower = 1;
+    std::size_t d_upper = length_left < length_right ? length_left
+                                                     : length_right;
+    while (d_lower < d_upper) {
+      std::size_t d = d_lower + (d_upper - d_lower) / 2;
+      if (comp(start_right + d * record_size, end_left - d * record_size))
+        d_lower = d + 1;
+      else
+        d_upper = d;
+    }
+    std::size_t d = d_lower;
+    mwob_namespace::SwapBlocks(start_right - d * record_size, start_right,
+                               start_right);
+    //Now merge [start_left, start_right) as the runs of length_left - d and
+    // d records and [start_right, one_past_end) as the runs of d and
+    // length_right - d records. The smaller of the two is merged recursively.
+    //The first of these has a trimmed left run and the second has a trimmed
+    // right run.
+    if (length_left <= length_right) {
+      MergeRecords(start_left, length_left - d, d, record_size, comp,
+                   true, false);
+      start_left   = start_right;
+      length_left  = d;
+      length_right = length_right - d;
+      is_left_trimmed  = false;
+      is_right_trimmed = true;
+    } else {
+      MergeRecords(start_right, d, length_right - d, record_size, comp,
+                   false, true);
+      length_left  = length_left - d;
+      length_right = d;
+      is_left_trimmed  = true;
+      is_right_trimmed = false;
+    }
+  }
+  return ;
+}
+
+template<std::size_t Size>
+inline void MergeFixedSizeRecords(void *base,
+                                  std::size_t num_records_left,
+                                  std::size_t num_records_right,
+                                  const RecordLess &comp) {
+  FixedSizeRecord<Size> *start_left =
+                                  static_cast<FixedSizeRecord<Size> *>(base);
+  FixedSizeRecord<Size> *start_right = start_left + num_records_left;
+  MergeWithOutBuffer1<FixedSizeRecord<Size> *, RecordLess, std::ptrdiff_t>(
+      start_left, start_right, start_right + num_records_right,
+      static_cast<std::ptrdiff_t>(num_records_left),
+      static_cast<std::ptrdiff_t>(num_records_right), comp);
+  return ;
+}
+
+} //END namespace: merge_without_buffer_records_namespace
+
+inline void MergeRecordsWithOutBuffer(void *base,
+                                      std::size_t num_records_left,
+                                      std::size_t num_records_right,
+                                      std::size_t record_size,
+                                      MwobRecordCompare comp,
+                                      void *context) {
+  using namespace merge_without_buffer_records_namespace;
+  if (num_records_left == 0 || num_records_right == 0 || record_size == 0)
+    return ;
+  RecordLess record_less{comp, context};
+  switch (record_size) {
+    case 8:
+      MergeFixedSizeRecords<8>(base, num_records_left, num_records_right,
+                               record_less);
+      break ;
+    case 16:
+      MergeFixedSizeRecords<16>(base, num_records_left, num_records_right,
+                                record_less);
+      break ;
+    case 32:
+      MergeFixedSizeRecords<32>(base, num_records_left, num_records_right,
+                                record_less);
+      break ;
+    case 64:
+      MergeFixedSizeRecords<64>(base, num_records_left, num_records_right,
+                                record_less);
+      break ;
+    default:
+      MergeRecords(static_cast<unsigned char *>(base), num_records_left,
+                   num_records_right, record_size, record_less, false, false);
+      break ;
+  }
+  return ;
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_RECORDS_H_ */
@@ -0,0 +1,107 @@
+/*
+ * merge_without_buffer_reduce.h
+ *
+ *  MergeReduceWithOutBuffer(start_left, start_right, one_past_end, comp,
+ *   combine) merges the adjacent sorted lists of records
+ *   [start_left, start_right) and [start_right, one_past_end) in place and
+ *   folds every group of records with equivalent keys (according to comp)
+ *   into a single record, e.g. to merge two sorted tables of counters. It
+ *   returns the new logical end new_end, like std::unique(): the result is
+ *   [start_left, new_end) and the records in [new_end, one_past_end) are
+ *   valid but unspecified (they may have been moved from).
+ *
+ *  Records are folded by calls combine(into, std::move(from)), which must
+ *   not change into's key. Since each list is reduced before the merge (see
+ *   below), the records of a group are not folded one at a time in the order
+ *   of the stable merge: the group's left records are folded, in order, into
+ *   its first left record, its right records are folded, in order, into its
+ *   first right record, and then the latter is folded into the former. So
+ *   combine must be associative (it need not be commutative), in which case
+ *   the result is the same as folding the group's records in the order of
+ *   the stable merge into its first record.
+ *
+ *  Instead of merging everything and then reducing the merged list, each
+ *   list is reduced first (which can only make the merge cheaper), the gap
+ *   between the two reduced lists is closed by a single rotation, the
+ *   reduced lists are merged by MergeWithOutBuffer1(), and finally the at
+ *   most two records per key (one from each list) are folded together.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  typedef std::pair<std::string, long> Counter;
+  std::vector<Counter> counters({ {"a", 1}, {"c", 2}, {"c", 1}, {"d", 5},
+                                  {"a", 3}, {"b", 1}, {"d", 1} });
+  //counters[0, 4) and counters[4, 7) are sorted by key.
+  auto by_key = [](const Counter &lhs, const Counter &rhs) -> bool {
+    return lhs.first < rhs.first;
+  };
+  auto add = [](Counter &into, Counter &&from) { into.second += from.second; };
+  auto new_end = MergeReduceWithOutBuffer(counters.begin(),
+                     counters.begin() + 4, counters.end(), by_key, add);
+  counters.erase(new_end, counters.end());
+  //counters is now { {"a", 4}, {"b", 1}, {"c", 3}, {"d", 6} }.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_REDUCE_H_
+#define SRC_MERGE_WITHOUT_BUFFER_REDUCE_H_
+
+#include <iterator>
+#include <utility>
+
+#include "merge_without_buffer1.h"
+
+namespace merge_without_buffer_reduce_namespace {
+
+//Folds every group of adjacent equivalent records of the sorted list
+// [start, one_past_end) into its first record, moves the resulting records
+// towards start, and returns the new logical end.
+template<typename ForwardIterator, typename Compare, typename Combine>
+inline ForwardIterator ReduceSorted(ForwardIterator start,
+                                    ForwardIterator one_past_end,
+                                    Compare comp,
+                                    Combine &combine) {
+  if (start == one_past_end)
+    return one_past_end;
+  ForwardIterator out = start;
+  ForwardIterator it  = start;
+  while (++it != one_past_end) {
+    if (comp(*out, *it)) {
+      (void)++out;
+      if (out != it)
+        *out = std::move(*it);
+    } else {
+      combine(*out, std::move(*it));
+    }
+  }
+  return ++out;
+}
+
+} //END namespace: merge_without_buffer_reduce_namespace
+
+template<typename BidirectionalIterator, typename Compare, typename Combine>
+inline BidirectionalIterator MergeReduceWithOutBuffer(
+                                          BidirectionalIterator start_left,
+                                          BidirectionalIterator start_right,
+                                          BidirectionalIterator one_past_end,
+                                          Compare comp,
+                                          Combine combine) {
+  using merge_without_buffer_reduce_namespace::ReduceSorted;
+  BidirectionalIterator one_past_end_left = ReduceSorted(start_left,
+                                               start_right, comp, combine);
+  BidirectionalIterator one_past_end_right = ReduceSorted(start_right,
+                                               one_past_end, comp, combine);
+  BidirectionalIterator new_end = one_past_end_right;
+  if (one_past_end_left != start_right) {
+    new_end = mwob_namespace::RotateBlocks(one_past_end_left, start_right,
+                                           one_past_end_right);
+  }
+  //The reduced right list now starts at one_past_end_left.
+  MergeWithOutBuffer1(start_left, one_past_end_left, new_end, comp);
+  return ReduceSorted(start_left, new_end, comp, combine);
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_REDUCE_H_ */
@@ -0,0 +1,62 @@
+/*
+ * merge_without_buffer_rotate.h
+ *
+ *  RotateWithOutBuffer(start, middle, one_past_end) is a drop-in replacement
+ *   for std::rotate(): it rotates [start, one_past_end) so that middle
+ *   becomes the first element and returns the new location of *start. It is
+ *   the rotation that MergeWithOutBuffer1() and MergeWithOutBuffer2() use
+ *   (i.e. mwob_namespace::RotateBlocks()), which picks its strategy by the
+ *   element type and the lengths of the two blocks:
+ *  (1) Trivially copyable types stored contiguously (contiguous iterators
+ *      are lowered to pointers): the Gries-Mills block swap algorithm with
+ *      tiled SIMD block swaps until the shorter block fits in
+ *      MWOB_ROTATE_STACK_BYTES bytes, after which the shorter block is copied
+ *      to the stack and the longer one is moved by a single std::memmove().
+ *  (2) Types whose moves are expensive (see
+ *      mwob_namespace::UseMoveMinimizingBlockExchange): cycle chasing
+ *      (juggling), which takes N + gcd(N, K) moves.
+ *  (3) Otherwise: std::rotate().
+ *  Memory is never allocated; at most MWOB_ROTATE_STACK_BYTES bytes of stack
+ *   are used.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> vec({ 1, 2, 3, 4, 5, 6, 7 });
+  auto new_location_of_1 = RotateWithOutBuffer(vec.begin(), vec.begin() + 2,
+                                               vec.end());
+  //vec is now { 3, 4, 5, 6, 7, 1, 2 } and new_location_of_1 == vec.begin() + 5.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_ROTATE_H_
+#define SRC_MERGE_WITHOUT_BUFFER_ROTATE_H_
+
+#include <iterator>
+#include <type_traits>
+
+#include "merge_without_buffer_common.h"
+
+template<typename ForwardIterator>
+MWOB_CONSTEXPR20
+inline ForwardIterator RotateWithOutBuffer(ForwardIterator start,
+                                           ForwardIterator middle,
+                                           ForwardIterator one_past_end) {
+  if constexpr (!std::is_pointer<ForwardIterator>::value &&
+        mwob_namespace::IsContiguousIterator<ForwardIterator>::value) {
+    //Lower contiguous iterators (e.g. std::vector<T>::iterator) to pointers.
+    if (start == one_past_end || mwob_namespace::IsConstantEvaluated())
+      return mwob_namespace::RotateBlocks(start, middle, one_past_end);
+    auto start_ptr = mwob_namespace::IteratorToPointer(start);
+    return start + (mwob_namespace::RotateBlocks(start_ptr,
+                                       start_ptr + (middle - start),
+                                       start_ptr + (one_past_end - start))
+                    - start_ptr);
+  } else {
+    return mwob_namespace::RotateBlocks(start, middle, one_past_end);
+  }
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_ROTATE_H_ */
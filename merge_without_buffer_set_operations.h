@@ -0,0 +1,177 @@
+/*
+ * merge_without_buffer_set_operations.h
+ *
+ *  In place set operations on two adjacent sorted lists, L = [start_left,
+ *   start_right) and R = [start_right, one_past_end), that need no buffer.
+ *   Each returns the new logical end new_end, like std::unique(): the result
+ *   is [start_left, new_end) and the elements in [new_end, one_past_end) are
+ *   valid but unspecified (they may have been moved from).
+ *
+ *  SetUnionWithOutBuffer() leaves exactly one element of each equivalence
+ *   class of L and R, namely the first one in their stable merge (so the
+ *   element of L if there is one). Duplicates are first removed from L and R
+ *   separately by std::unique(), the gap between them is closed by a single
+ *   rotation, the two (now shorter) lists are merged by MergeWithOutBuffer1(),
+ *   and duplicates that came from different lists, which are now adjacent,
+ *   are removed by std::unique().
+ *  SetIntersectionWithOutBuffer() and SetDifferenceWithOutBuffer() have the
+ *   same (multiset) semantics as std::set_intersection() and
+ *   std::set_difference() with L as the first range: if an element occurs m
+ *   times in L and n times in R then the first min(m, n) (resp. the last
+ *   max(m - n, 0)) of its m occurrences in L are kept. These only need a
+ *   single pass over L and R that moves the kept elements of L towards
+ *   start_left, which is safe since the kept elements are written to
+ *   positions that have already been read. Their order is preserved.
+ *
+ *  Union requires bidirectional iterators; intersection and difference only
+ *   require forward iterators. Each performs O(length_left + length_right)
+ *   comparisons and moves apart from the merge in SetUnionWithOutBuffer().
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> vec({ 1, 3, 3, 5, 7, 2, 3, 5, 6 });
+  //vec[0, 5) and vec[5, 9) are sorted.
+  auto new_end = SetUnionWithOutBuffer(vec.begin(), vec.begin() + 5, vec.end());
+  vec.erase(new_end, vec.end());
+  //vec is now { 1, 2, 3, 5, 6, 7 }.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_SET_OPERATIONS_H_
+#define SRC_MERGE_WITHOUT_BUFFER_SET_OPERATIONS_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "merge_without_buffer1.h"
+
+template<typename BidirectionalIterator, typename Compare>
+inline BidirectionalIterator SetUnionWithOutBuffer(
+                                          BidirectionalIterator start_left,
+                                          BidirectionalIterator start_right,
+                                          BidirectionalIterator one_past_end,
+                                          Compare comp) {
+  typedef typename std::iterator_traits<BidirectionalIterator>::value_type
+                                                                     ValueType;
+  //Within a sorted list, lhs precedes rhs so they are equivalent if and
+  // only if !comp(lhs, rhs).
+  auto is_equivalent = [comp](const ValueType &lhs,
+                              const ValueType &rhs) -> bool {
+    return !comp(lhs, rhs);
+  };
+  BidirectionalIterator one_past_end_left = std::unique(start_left,
+                                                 start_right, is_equivalent);
+  BidirectionalIterator one_past_end_right = std::unique(start_right,
+                                                 one_past_end, is_equivalent);
+  BidirectionalIterator new_end = one_past_end_right;
+  if (one_past_end_left != start_right) {
+    new_end = mwob_namespace::RotateBlocks(one_past_end_left, start_right,
+                                           one_past_end_right);
+  }
+  //The right list now starts at one_past_end_left.
+  MergeWithOutBuffer1(start_left, one_past_end_left, new_end, comp);
+  return std::unique(start_left, new_end, is_equivalent);
+}
+
+template<typename BidirectionalIterator>
+inline BidirectionalIterator SetUnionWithOutBuffer(
+                                          BidirectionalIterator start_left,
+                                          BidirectionalIterator start_right,
+                                          BidirectionalIterator one_past_end) {
+  typedef typename std::iterator_traits<BidirectionalIterator>::value_type
+                                                                     ValueType;
+  return SetUnionWithOutBuffer(start_left, start_right, one_past_end,
+                               std::less<ValueType>());
+}
+
+template<typename ForwardIterator, typename Compare>
+inline ForwardIterator SetIntersectionWithOutBuffer(
+                                              ForwardIterator start_left,
+                                              ForwardIterator start_right,
+                                              ForwardIterator one_past_end,
+                                              Compare comp) {
+  ForwardIterator out   = start_left;
+  ForwardIterator left  = start_left;
+  ForwardIterator right = start_right;
+  while (left != start_right && right != one_past_end) {
+    if (comp(*left, *right)) {
+      (void)++left;
+    } else {
+      if (!comp(*right, *left)) {
+        if (out != left)
+          *out = std::move(*left);
+        (void)++out;
+        (void)++left;
+      }
+      (void)++right;
+    }
+  }
+  return out;
+}
+
+template<typename ForwardIterator>
+inline ForwardIterator SetIntersectionWithOutBuffer(
+                                              ForwardIterator start_left,
+                                              ForwardIterator start_right,
+                                              ForwardIterator one_past_end) {
+  typedef typename std::iterator_traits<ForwardIterator>::value_type ValueType;
+  return SetIntersectionWithOutBuffer(start_left, start_right, one_past_end,
+                                      std::less<ValueType>());
+}
+
+//Removes from [start_left, start_right) the elements that are matched by
+// elements of [start_right, one_past_end).
+template<typename ForwardIterator, typename Compare>
+inline ForwardIterator SetDifferenceWithOutBuffer(
+                                              ForwardIterator start_left,
+                                              ForwardIterator start_right,
+                                              ForwardIterator one_past_end,
+                                              Compare comp) {
+  ForwardIterator left  = start_left;
+  ForwardIterator right = start_right;
+  //Until the first element is removed every kept element is already in
+  // place, so nothing needs to be moved.
+  while (true) {
+    if (left == start_right || right == one_past_end)
+      return start_right;
+    if (comp(*left, *right)) {
+      (void)++left;
+    } else {
+      if (!comp(*right, *left))
+        break ;
+      (void)++right;
+    }
+  }
+  ForwardIterator out = left;
+  (void)++left;
+  (void)++right;
+  while (left != start_right && right != one_past_end) {
+    if (comp(*left, *right)) {
+      *out = std::move(*left);
+      (void)++out;
+      (void)++left;
+    } else {
+      if (!comp(*right, *left))
+        (void)++left;
+      (void)++right;
+    }
+  }
+  return std::move(left, start_right, out);
+}
+
+template<typename ForwardIterator>
+inline ForwardIterator SetDifferenceWithOutBuffer(
+                                              ForwardIterator start_left,
+                                              ForwardIterator start_right,
+                                              ForwardIterator one_past_end) {
+  typedef typename std::iterator_traits<ForwardIterator>::value_type ValueType;
+  return SetDifferenceWithOutBuffer(start_left, start_right, one_past_end,
+                                    std::less<ValueType>());
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_SET_OPERATIONS_H_ */
@@ -0,0 +1,99 @@
+/*
+ * merge_without_buffer_sort.h
+ *
+ *  StableSortWithOutBuffer() is a stable in-place sort that never allocates
+ *   a buffer. Blocks of MWOB_SORT_INSERTION_LENGTH elements are first sorted
+ *   by (stable) insertion sort and then adjacent sorted blocks are merged,
+ *   bottom-up, by MergeWithOutBuffer1().
+ *  It performs O(N log(N)^2) operations in the worst case. Unlike
+ *   std::stable_sort() it does not try to allocate a temporary buffer, so it
+ *   can be used where (large) allocations are unwanted or impossible.
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_SORT_H_
+#define SRC_MERGE_WITHOUT_BUFFER_SORT_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "merge_without_buffer1.h"
+
+#ifndef MWOB_SORT_INSERTION_LENGTH
+#define MWOB_SORT_INSERTION_LENGTH 16
+#endif
+
+namespace merge_without_buffer_sort_namespace {
+
+//Stable insertion sort of [start, one_past_end).
+template<typename BidirectionalIterator, typename Compare>
+inline void InsertionSort(BidirectionalIterator start,
+                          BidirectionalIterator one_past_end,
+                          Compare comp) {
+  if (start == one_past_end)
+    return ;
+  auto it = start;
+  for ((void)++it; it != one_past_end; (void)++it) {
+    auto previous = it;
+    (void)--previous;
+    if (!comp(*it, *previous))
+      continue ;
+    auto value = std::move(*it);
+    auto hole  = it;
+    do {
+      *hole = std::move(*previous);
+      hole  = previous;
+    } while (hole != start && comp(value, *(--previous)));
+    *hole = std::move(value);
+  }
+  return ;
+}
+
+} //END namespace: merge_without_buffer_sort_namespace
+
+template<typename Iterator, typename Compare>
+inline void StableSortWithOutBuffer(Iterator start,
+                                    Iterator one_past_end,
+                                    Compare comp) {
+  typedef typename std::iterator_traits<Iterator>::difference_type Distance;
+  Distance length = std::distance(start, one_past_end);
+  if (length < 2)
+    return ;
+  const Distance block_length = MWOB_SORT_INSERTION_LENGTH > 1 ?
+                                MWOB_SORT_INSERTION_LENGTH : 1;
+  {
+    auto block_start = start;
+    for (Distance i = 0; i < length; i += block_length) {
+      auto block_end = block_start;
+      std::advance(block_end, std::min(block_length, length - i));
+      merge_without_buffer_sort_namespace::InsertionSort(block_start,
+                                                         block_end, comp);
+      block_start = block_end;
+    }
+  }
+  for (Distance width = block_length; width < length; width *= 2) {
+    auto start_left = start;
+    for (Distance i = 0; i + width < length; i += 2 * width) {
+      Distance length_left  = width;
+      Distance length_right = std::min(width, length - (i + width));
+      auto start_right = start_left;
+      std::advance(start_right, length_left);
+      auto one_past_end_right = start_right;
+      std::advance(one_past_end_right, length_right);
+      MergeWithOutBuffer1<Iterator, Compare, Distance>(start_left, start_right,
+                       one_past_end_right, length_left, length_right, comp);
+      start_left = one_past_end_right;
+    }
+  }
+  return ;
+}
+
+template<typename Iterator>
+inline void StableSortWithOutBuffer(Iterator start, Iterator one_past_end) {
+  typedef typename std::iterator_traits<Iterator>::value_type ValueType;
+  StableSortWithOutBuffer(start, one_past_end, std::less<ValueType>());
+  return ;
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_SORT_H_ */
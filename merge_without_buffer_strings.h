@@ -0,0 +1,152 @@
+/*
+ * merge_without_buffer_strings.h
+ *
+ *  SharedPrefixLess<StringType> orders strings (std::string,
+ *   std::string_view, and other sequences of characters) lexicographically,
+ *   exactly like std::less<StringType>, except that it remembers a prefix
+ *   length that all of the strings it compares are known to share and starts
+ *   every comparison past this prefix.
+ *  When it is passed to MergeWithOutBuffer1() or MergeWithOutBuffer2() with
+ *   random access iterators, the recursion raises this length at the start
+ *   of every (trimmed) subproblem to the longest common prefix (LCP) of the
+ *   subproblem's least and greatest strings (see
+ *   mwob_namespace::RaiseSharedPrefixLength_RAI()), which every string in
+ *   the subproblem shares. Computing it only scans the characters past the
+ *   parent subproblem's shared prefix (8 bytes at a time), and each of the
+ *   subproblem's O(log(N)) comparisons (by the trims and
+ *   DisplacementToPotentialMedians_KnownToExist_RAI()) and those of its
+ *   subproblems then skip it.
+ *  This pays off for keys with long common prefixes, such as URLs and file
+ *   paths, since the subproblems deep in the recursion consist of strings
+ *   that are close together in sorted order and so share long prefixes.
+ *   Since memcmp() is fast, the gain is only noticeable once the shared
+ *   prefixes are hundreds of bytes long. Subproblems with fewer than
+ *   MWOB_SHARED_PREFIX_MIN_LENGTH elements keep their parent's length.
+ *
+ *  MergeStringsWithOutBuffer(start_left, start_right, one_past_end) is
+ *   MergeWithOutBuffer1() with a SharedPrefixLess.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<std::string> urls({ "https://a.org/x/1", "https://a.org/x/3",
+                                  "https://a.org/x/2", "https://a.org/y" });
+  //urls[0, 2) and urls[2, 4) are sorted.
+  MergeStringsWithOutBuffer(urls.begin(), urls.begin() + 2, urls.end());
+  //urls is now { "https://a.org/x/1", "https://a.org/x/2",
+  //              "https://a.org/x/3", "https://a.org/y" }.
+  }
+
+ */
+
+#ifndef SRC_MERGE_WITHOUT_BUFFER_STRINGS_H_
+#define SRC_MERGE_WITHOUT_BUFFER_STRINGS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "merge_without_buffer1.h"
+
+namespace merge_without_buffer_strings_namespace {
+
+template<typename StringType, typename = void>
+struct HasCharTraits : std::false_type {};
+
+template<typename StringType>
+struct HasCharTraits<StringType,
+                     std::void_t<typename StringType::traits_type>>
+    : std::true_type {};
+
+} //END namespace: merge_without_buffer_strings_namespace
+
+template<typename StringType>
+class SharedPrefixLess {
+public:
+  //Assumes that: every string that will be compared starts with the same
+  // shared_prefix_length characters.
+  MWOB_CONSTEXPR20 explicit SharedPrefixLess(
+                                        std::size_t shared_prefix_length = 0)
+      : shared_prefix_length_(shared_prefix_length) {
+  }
+
+  MWOB_CONSTEXPR20 bool operator()(const StringType &lhs,
+                                   const StringType &rhs) const {
+    using merge_without_buffer_strings_namespace::HasCharTraits;
+    if constexpr (HasCharTraits<StringType>::value) {
+      typedef typename StringType::traits_type Traits;
+      std::size_t length = std::min(lhs.size(), rhs.size())
+                         - shared_prefix_length_;
+      int result = Traits::compare(lhs.data() + shared_prefix_length_,
+                                   rhs.data() + shared_prefix_length_, length);
+      return result < 0 || (result == 0 && lhs.size() < rhs.size());
+    } else {
+      return std::lexicographical_compare(
+                   std::next(std::begin(lhs), shared_prefix_length_),
+                   std::end(lhs),
+                   std::next(std::begin(rhs), shared_prefix_length_),
+                   std::end(rhs));
+    }
+  }
+
+  //Raises the shared prefix length to the length of the longest common
+  // prefix of min_value and max_value.
+  //Assumes that: every string that will be compared from now on lies
+  // between min_value and max_value (inclusive).
+  MWOB_CONSTEXPR20 void RaiseSharedPrefixLength(const StringType &min_value,
+                                                const StringType &max_value) {
+    shared_prefix_length_ = CommonPrefixLength(min_value, max_value);
+    return ;
+  }
+
+  MWOB_CONSTEXPR20 std::size_t SharedPrefixLength() const {
+    return shared_prefix_length_;
+  }
+
+private:
+  //Returns the length of the longest common prefix of lhs and rhs, which
+  // is at least shared_prefix_length_.
+  MWOB_CONSTEXPR20 std::size_t CommonPrefixLength(const StringType &lhs,
+                                                  const StringType &rhs) const {
+    using merge_without_buffer_strings_namespace::HasCharTraits;
+    std::size_t length = shared_prefix_length_;
+    if constexpr (HasCharTraits<StringType>::value) {
+      if (!mwob_namespace::IsConstantEvaluated()) {
+        //Compare 8 bytes at a time until they differ.
+        typedef typename StringType::value_type CharType;
+        constexpr std::size_t kChunkLength = 8 / sizeof(CharType) > 0 ?
+                                             8 / sizeof(CharType) : 1;
+        std::size_t min_size = std::min(lhs.size(), rhs.size());
+        while (length + kChunkLength <= min_size &&
+               std::memcmp(lhs.data() + length, rhs.data() + length,
+                           kChunkLength * sizeof(CharType)) == 0)
+          length += kChunkLength;
+      }
+    }
+    auto start_lhs = std::next(std::begin(lhs), length);
+    auto start_rhs = std::next(std::begin(rhs), length);
+    auto mismatch = std::mismatch(start_lhs, std::end(lhs),
+                                  start_rhs, std::end(rhs));
+    return length + static_cast<std::size_t>(
+                                   std::distance(start_lhs, mismatch.first));
+  }
+
+  std::size_t shared_prefix_length_;
+};
+
+template<typename Iterator>
+MWOB_CONSTEXPR20
+inline void MergeStringsWithOutBuffer(Iterator start_left,
+                                      Iterator start_right,
+                                      Iterator one_past_end) {
+  typedef typename std::iterator_traits<Iterator>::value_type StringType;
+  MergeWithOutBuffer1(start_left, start_right, one_past_end,
+                      SharedPrefixLess<StringType>());
+  return ;
+}
+
+#endif /* SRC_MERGE_WITHOUT_BUFFER_STRINGS_H_ */
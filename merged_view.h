@@ -0,0 +1,283 @@
+/*
+ * merged_view.h
+ *
+ *  merged_view<RandomAccessIterator, Compare> is a read-only view of two
+ *   sorted ranges, left and right, whose iterators visit the elements of
+ *   both in the order of their stable merge (i.e. left elements precede
+ *   equivalent right elements) without moving or copying any of them.
+ *  An iterator is the split (i, j) of the merge at its position i + j (see
+ *   CoRank()) together with the side whose next element is the one that it
+ *   points to, so:
+ *  (1) ++ and -- perform a single comparison,
+ *  (2) +=, -=, +, -, and [] seek straight to the new position by CoRank(),
+ *      which performs O(log(n)) comparisons, and
+ *  (3) the difference of two iterators and their ordering are given by
+ *      their positions.
+ *  The view and each of its iterators hold copies of the starts and
+ *   lengths of left and right and of the comparison object, so views are
+ *   copyable and their iterators remain valid after the view is copied or
+ *   destroyed. Iterators into left and right that would be invalidated also
+ *   invalidate the view's iterators.
+ *
+ *  The member functions are named after those of the standard library's
+ *   containers and ranges.
+ */
+
+/* EXAMPLE CALL:
+
+  {
+  std::vector<int> left({ 1, 4, 6, 9 });
+  std::vector<int> right({ 2, 3, 8 });
+  merged_view view(left, right, std::less<int>());
+  for (int value : view)
+    std::cout << value << ' ';     //1 2 3 4 6 8 9
+  int median = view[view.size() / 2]; //4
+  auto page = view.begin() + 4;       //Seeks to offset 4 in O(log(n)).
+  }
+
+ */
+
+#ifndef SRC_MERGED_VIEW_H_
+#define SRC_MERGED_VIEW_H_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "merge_without_buffer_corank.h"
+
+template<typename RandomAccessIterator,
+         typename Compare = std::less<
+             typename std::iterator_traits<RandomAccessIterator>::value_type>>
+class merged_view {
+public:
+  typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+                                                                    value_type;
+  typedef typename std::iterator_traits<RandomAccessIterator>::difference_type
+                                                               difference_type;
+  //Elements are only ever read through the view, so if the underlying
+  // iterators yield (possibly non-const) lvalue references then the view
+  // yields const lvalue references, and otherwise (e.g. proxy references)
+  // it yields copies of the elements.
+  typedef typename std::conditional<std::is_reference<typename
+            std::iterator_traits<RandomAccessIterator>::reference>::value,
+            const value_type &, value_type>::type reference;
+  typedef reference const_reference;
+  typedef std::size_t size_type;
+  typedef Compare value_compare;
+
+private:
+  //The starts and lengths of left and right and the comparison object.
+  struct Ranges {
+    RandomAccessIterator start_left;
+    RandomAccessIterator start_right;
+    difference_type length_left;
+    difference_type length_right;
+    Compare comp;
+  };
+
+public:
+  class const_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename merged_view::value_type value_type;
+    typedef typename merged_view::difference_type difference_type;
+    typedef typename merged_view::reference reference;
+    typedef const value_type *pointer;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      return is_left_ ? *(ranges_.start_left + i_)
+                      : *(ranges_.start_right + j_);
+    }
+    pointer operator->() const { return std::addressof(**this); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    //The underlying iterator that this iterator points to.
+    RandomAccessIterator base() const {
+      return is_left_ ? ranges_.start_left + i_ : ranges_.start_right + j_;
+    }
+    //The split (i, j) of the merge at this iterator's position.
+    std::pair<difference_type, difference_type> split() const {
+      return std::pair<difference_type, difference_type>(i_, j_);
+    }
+    difference_type position() const { return i_ + j_; }
+
+    const_iterator &operator++() {
+      if (is_left_)
+        i_++;
+      else
+        j_++;
+      SetSideOfNext();
+      return *this;
+    }
+
+    const_iterator &operator--() {
+      //The element before position i_ + j_ is the greater of left[i_ - 1]
+      // and right[j_ - 1] where, of two equivalent elements, the right one
+      // is the greater.
+      if (j_ == 0 ||
+          (i_ != 0 && ranges_.comp(*(ranges_.start_right + (j_ - 1)),
+                                   *(ranges_.start_left + (i_ - 1)))))
+        i_--;
+      else
+        j_--;
+      SetSideOfNext();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+    const_iterator operator--(int) {
+      const_iterator copy = *this;
+      --*this;
+      return copy;
+    }
+
+    const_iterator &operator+=(difference_type n) {
+      if (n == 1)
+        return ++*this;
+      if (n == -1)
+        return --*this;
+      if (n != 0)
+        Seek(i_ + j_ + n);
+      return *this;
+    }
+    const_iterator &operator-=(difference_type n) { return *this += -n; }
+
+    friend const_iterator operator+(const_iterator it, difference_type n) {
+      return it += n;
+    }
+    friend const_iterator operator+(difference_type n, const_iterator it) {
+      return it += n;
+    }
+    friend const_iterator operator-(const_iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const const_iterator &lhs,
+                                     const const_iterator &rhs) {
+      return lhs.position() - rhs.position();
+    }
+
+    friend bool operator==(const const_iterator &lhs,
+                           const const_iterator &rhs) {
+      return lhs.position() == rhs.position();
+    }
+    friend bool operator!=(const const_iterator &lhs,
+                           const const_iterator &rhs) {
+      return lhs.position() != rhs.position();
+    }
+    friend bool operator<(const const_iterator &lhs,
+                          const const_iterator &rhs) {
+      return lhs.position() < rhs.position();
+    }
+    friend bool operator>(const const_iterator &lhs,
+                          const const_iterator &rhs) {
+      return lhs.position() > rhs.position();
+    }
+    friend bool operator<=(const const_iterator &lhs,
+                           const const_iterator &rhs) {
+      return lhs.position() <= rhs.position();
+    }
+    friend bool operator>=(const const_iterator &lhs,
+                           const const_iterator &rhs) {
+      return lhs.position() >= rhs.position();
+    }
+
+  private:
+    friend class merged_view;
+
+    const_iterator(const Ranges &ranges, difference_type position)
+        : ranges_(ranges) {
+      Seek(position);
+    }
+
+    void Seek(difference_type position) {
+      std::pair<difference_type, difference_type> split =
+          CoRank<RandomAccessIterator, Compare, difference_type>(
+              ranges_.start_left, ranges_.start_left + ranges_.length_left,
+              ranges_.start_right, ranges_.start_right + ranges_.length_right,
+              position, ranges_.comp);
+      i_ = split.first;
+      j_ = split.second;
+      SetSideOfNext();
+      return ;
+    }
+
+    //The next element is left[i_] unless left is exhausted or right[j_] is
+    // less than it.
+    void SetSideOfNext() {
+      is_left_ = i_ != ranges_.length_left && (j_ == ranges_.length_right ||
+                 !ranges_.comp(*(ranges_.start_right + j_),
+                               *(ranges_.start_left + i_)));
+      return ;
+    }
+
+    Ranges ranges_{};
+    difference_type i_ = 0;
+    difference_type j_ = 0;
+    bool is_left_ = false;
+  };
+  typedef const_iterator iterator;
+
+  merged_view(RandomAccessIterator start_left,
+              RandomAccessIterator one_past_end_left,
+              RandomAccessIterator start_right,
+              RandomAccessIterator one_past_end_right,
+              Compare comp = Compare())
+      : ranges_{ start_left, start_right, one_past_end_left - start_left,
+                 one_past_end_right - start_right, comp } {
+  }
+
+  template<typename Range>
+  merged_view(Range &left, Range &right, Compare comp = Compare())
+      : merged_view(std::begin(left), std::end(left),
+                    std::begin(right), std::end(right), comp) {
+  }
+
+  merged_view(const merged_view &) = default;
+  merged_view &operator=(const merged_view &) = default;
+
+  const_iterator begin() const { return const_iterator(ranges_, 0); }
+  const_iterator end() const { return const_iterator(ranges_, Length()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  //Returns an iterator to the element at the given position of the merge.
+  const_iterator iterator_at(difference_type position) const {
+    return const_iterator(ranges_, position);
+  }
+  reference operator[](difference_type position) const {
+    return *iterator_at(position);
+  }
+  reference front() const { return *begin(); }
+  reference back() const { return *iterator_at(Length() - 1); }
+
+  size_type size() const { return static_cast<size_type>(Length()); }
+  bool empty() const { return Length() == 0; }
+  value_compare value_comp() const { return ranges_.comp; }
+
+private:
+  difference_type Length() const {
+    return ranges_.length_left + ranges_.length_right;
+  }
+
+  Ranges ranges_;
+};
+
+template<typename Range, typename Compare>
+merged_view(Range &, Range &, Compare)
+    -> merged_view<decltype(std::begin(std::declval<Range &>())), Compare>;
+
+template<typename Range>
+merged_view(Range &, Range &)
+    -> merged_view<decltype(std::begin(std::declval<Range &>()))>;
+
+#endif /* SRC_MERGED_VIEW_H_ */